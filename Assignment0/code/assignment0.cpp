@@ -1,62 +1,445 @@
+#include <algorithm>
 #include <cstddef>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "catch.hpp"
 
-// This code is taken from: https://github.com/ReneNyffenegger.
-// The code was distributed under the LICENSE:
-// https://github.com/ReneNyffenegger/cpp-base64/blob/master/LICENSE
+#include "base64.hpp"
 
-constexpr char const* base64_chars = {
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+STUDENT_TEST("Calculate the base64 encoding for your name")
+{
+    CHECK(base64_encode("Riley Oest") == "UmlsZXkgT2VzdA==");
+}
+
+STUDENT_TEST("base64_encode matches the RFC 4648 test vectors")
+{
+    CHECK(base64_encode("") == "");
+    CHECK(base64_encode("f") == "Zg==");
+    CHECK(base64_encode("fo") == "Zm8=");
+    CHECK(base64_encode("foo") == "Zm9v");
+    CHECK(base64_encode("foob") == "Zm9vYg==");
+    CHECK(base64_encode("fooba") == "Zm9vYmE=");
+    CHECK(base64_encode("foobar") == "Zm9vYmFy");
+}
+
+STUDENT_TEST("SIMD kernels match the scalar encoder for all sizes and alignments")
+{
+    // pseudo random bytes covering the whole range of values, including
+    // the ones above 0x7f
+    std::string buffer(1024, '\0');
+    unsigned state = 12345;
+    for (char& c : buffer)
+    {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+
+    for (base64_isa isa :
+        {base64_isa::ssse3, base64_isa::avx2, base64_isa::avx512})
+    {
+        if (!base64_isa_supported(isa))
+        {
+            continue;
+        }
+
+        INFO("isa: " << base64_isa_name(isa));
+        for (std::size_t offset = 0; offset != 64; ++offset)
+        {
+            for (std::size_t size = 0; offset + size <= 400; ++size)
+            {
+                std::string const input = buffer.substr(offset, size);
+                REQUIRE(base64_encode(input, isa) ==
+                    base64_encode(input, base64_isa::scalar));
+            }
+        }
+
+        std::string const input = buffer.substr(1);
+        CHECK(base64_encode(input, isa) ==
+            base64_encode(input, base64_isa::scalar));
+    }
+}
+
+STUDENT_TEST("base64_encode uses the best supported kernel")
+{
+    CHECK(base64_isa_supported(base64_isa::scalar));
+    CHECK(base64_isa_supported(base64_detect_isa()));
+
+    std::string const input(1000, '\xfe');
+    CHECK(base64_encode(input) == base64_encode(input, base64_isa::scalar));
+}
+
+// Returns the offset reported by base64_decode for the given input, or -1
+// if the input was decoded successfully.
+long decode_error_offset(std::string const& encoded, base64_isa isa)
+{
+    try
+    {
+        base64_decode(encoded, isa);
+    }
+    catch (base64_error const& e)
+    {
+        return static_cast<long>(e.offset());
+    }
+    return -1;
+}
+
+STUDENT_TEST("base64_decode reverses the RFC 4648 test vectors")
+{
+    CHECK(base64_decode("") == "");
+    CHECK(base64_decode("Zg==") == "f");
+    CHECK(base64_decode("Zm8=") == "fo");
+    CHECK(base64_decode("Zm9v") == "foo");
+    CHECK(base64_decode("Zm9vYg==") == "foob");
+    CHECK(base64_decode("Zm9vYmE=") == "fooba");
+    CHECK(base64_decode("Zm9vYmFy") == "foobar");
+    CHECK(base64_decode("UmlsZXkgT2VzdA==") == "Riley Oest");
+}
 
-std::string base64_encode(std::string const& bytes_to_encode)
+STUDENT_TEST("base64_decode reports the offset of the first invalid byte")
 {
-    std::size_t in_len = bytes_to_encode.size();
-    std::size_t len_encoded = (in_len + 2) / 3 * 4;
+    for (base64_isa isa : {base64_isa::scalar, base64_isa::avx2,
+             base64_isa::avx512})
+    {
+        if (!base64_isa_supported(isa))
+        {
+            continue;
+        }
+
+        INFO("isa: " << base64_isa_name(isa));
 
-    constexpr unsigned char trailing_char = '=';
+        // truncated input
+        CHECK(decode_error_offset("Z", isa) == 1);
+        CHECK(decode_error_offset("Zg", isa) == 2);
+        CHECK(decode_error_offset("Zg=", isa) == 3);
+        CHECK(decode_error_offset("Zm9vY", isa) == 5);
 
-    std::string ret;
-    ret.reserve(len_encoded);
+        // misplaced padding
+        CHECK(decode_error_offset("=", isa) == 0);
+        CHECK(decode_error_offset("Z===", isa) == 1);
+        CHECK(decode_error_offset("Zg=a", isa) == 3);
+        CHECK(decode_error_offset("Zg==Zm9v", isa) == 4);
+        CHECK(decode_error_offset("Zm8==", isa) == 4);
+
+        // padding hiding non-zero bits
+        CHECK(decode_error_offset("Zh==", isa) == 2);
+        CHECK(decode_error_offset("Zm9=", isa) == 3);
+
+        // characters that are not part of the alphabet
+        CHECK(decode_error_offset("Zm9v\nYmFy", isa) == 4);
+        CHECK(decode_error_offset("Zm-v", isa) == 2);
+    }
+}
 
-    unsigned int pos = 0;
+STUDENT_TEST("SIMD decoders detect every invalid byte at every position")
+{
+    std::string const input(300, '\xa5');
+    std::string const valid = base64_encode(input);
 
-    while (pos < in_len)
+    for (base64_isa isa : {base64_isa::avx2, base64_isa::avx512})
     {
-        ret.push_back(base64_chars[(bytes_to_encode[pos + 0] & 0xfc) >> 2]);
-        if (pos + 1 < in_len)
+        if (!base64_isa_supported(isa))
         {
-            ret.push_back(
-                base64_chars[((bytes_to_encode[pos + 0] & 0x03) << 4) +
-                    ((bytes_to_encode[pos + 1] & 0xf0) >> 4)]);
+            continue;
+        }
+
+        INFO("isa: " << base64_isa_name(isa));
+        REQUIRE(base64_decode(valid, isa) == input);
 
-            if (pos + 2 < in_len)
+        for (std::size_t pos = 0; pos != valid.size(); ++pos)
+        {
+            for (int c = 0; c != 256; ++c)
             {
-                ret.push_back(
-                    base64_chars[((bytes_to_encode[pos + 1] & 0x0f) << 2) +
-                        ((bytes_to_encode[pos + 2] & 0xc0) >> 6)]);
-                ret.push_back(base64_chars[bytes_to_encode[pos + 2] & 0x3f]);
+                std::string encoded = valid;
+                encoded[pos] = static_cast<char>(c);
+                if (std::string(base64_chars).find(encoded[pos]) !=
+                    std::string::npos)
+                {
+                    continue;
+                }
+                REQUIRE(decode_error_offset(encoded, isa) ==
+                    static_cast<long>(pos));
             }
-            else
+        }
+    }
+}
+
+STUDENT_TEST("base64_decode round-trips base64_encode for all sizes and alignments")
+{
+    std::string buffer(1024, '\0');
+    unsigned state = 54321;
+    for (char& c : buffer)
+    {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+
+    for (base64_isa isa : {base64_isa::scalar, base64_isa::avx2,
+             base64_isa::avx512})
+    {
+        if (!base64_isa_supported(isa))
+        {
+            continue;
+        }
+
+        INFO("isa: " << base64_isa_name(isa));
+        for (std::size_t offset = 0; offset != 16; ++offset)
+        {
+            for (std::size_t size = 0; offset + size <= 400; ++size)
             {
-                ret.push_back(
-                    base64_chars[(bytes_to_encode[pos + 1] & 0x0f) << 2]);
-                ret.push_back(trailing_char);
+                std::string const input = buffer.substr(offset, size);
+                std::string const encoded = base64_encode(input);
+                REQUIRE(base64_decode(encoded, isa) == input);
             }
         }
-        else
+
+        std::string const encoded = base64_encode(buffer);
+        CHECK(base64_decode(encoded, isa) == buffer);
+    }
+}
+
+// Split `input` into chunks of the given sizes (cycling through them) and
+// feed them to a base64_encoder one at a time.
+std::string encode_in_chunks(
+    std::string const& input, std::vector<std::size_t> const& sizes)
+{
+    base64_encoder encoder;
+    std::string result;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; pos != input.size(); ++i)
+    {
+        std::size_t size = std::min(sizes[i % sizes.size()], input.size() - pos);
+        auto chunk = std::as_bytes(std::span(input.data() + pos, size));
+
+        std::string out(encoder.max_output_size(size), '\0');
+        out.resize(encoder.update(chunk, out));
+        result += out;
+        pos += size;
+    }
+
+    char last[4];
+    result.append(last, encoder.finish(last));
+    return result;
+}
+
+// Same as above for a base64_decoder.
+std::string decode_in_chunks(
+    std::string const& input, std::vector<std::size_t> const& sizes)
+{
+    base64_decoder decoder;
+    std::string result;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; pos != input.size(); ++i)
+    {
+        std::size_t size = std::min(sizes[i % sizes.size()], input.size() - pos);
+
+        std::string out(decoder.max_output_size(size), '\0');
+        out.resize(decoder.update(std::span(input.data() + pos, size),
+            std::as_writable_bytes(std::span(out))));
+        result += out;
+        pos += size;
+    }
+    decoder.finish();
+    return result;
+}
+
+STUDENT_TEST("base64_encoder and base64_decoder handle any chunking")
+{
+    std::string input(1000, '\0');
+    unsigned state = 4711;
+    for (char& c : input)
+    {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+
+    std::vector<std::vector<std::size_t>> const chunkings = {
+        {1}, {2}, {3}, {4}, {5}, {7, 1}, {64}, {100, 1, 2}, {1000}};
+
+    for (std::size_t size : {0, 1, 2, 3, 4, 5, 47, 48, 49, 200, 1000})
+    {
+        std::string const bytes = input.substr(0, size);
+        std::string const encoded = base64_encode(bytes);
+        for (auto const& sizes : chunkings)
         {
-            ret.push_back(base64_chars[(bytes_to_encode[pos + 0] & 0x03) << 4]);
-            ret.push_back(trailing_char);
-            ret.push_back(trailing_char);
+            REQUIRE(encode_in_chunks(bytes, sizes) == encoded);
+            REQUIRE(decode_in_chunks(encoded, sizes) == bytes);
         }
-        pos += 3;
     }
-    return ret;
 }
 
-STUDENT_TEST("Calculate the base64 encoding for your name")
+STUDENT_TEST("base64_decoder reports errors relative to the whole stream")
 {
-    CHECK(base64_encode("Riley Oest") == "UmlsZXkgT2VzdA==");
+    auto error_offset = [](std::string const& encoded, std::size_t chunk) {
+        try
+        {
+            decode_in_chunks(encoded, {chunk});
+        }
+        catch (base64_error const& e)
+        {
+            return static_cast<long>(e.offset());
+        }
+        return -1L;
+    };
+
+    for (std::size_t chunk : {1, 2, 3, 5, 6, 100})
+    {
+        INFO("chunk size: " << chunk);
+        CHECK(error_offset("Zm9vYmFy", chunk) == -1);
+        CHECK(error_offset("Zm9vYmE=", chunk) == -1);
+        CHECK(error_offset("Zm9vY", chunk) == 5);
+        CHECK(error_offset("Zm9vYm!y", chunk) == 6);
+        CHECK(error_offset("Zm9vYg==Zm9v", chunk) == 8);
+        CHECK(error_offset("Zm9vYh==", chunk) == 6);
+    }
+}
+
+STUDENT_TEST("base64 stream functions round-trip through iostreams")
+{
+    // larger than the chunks used internally
+    std::string input(100000, '\0');
+    for (std::size_t i = 0; i != input.size(); ++i)
+    {
+        input[i] = static_cast<char>(i * 7 + i / 251);
+    }
+
+    std::istringstream plain(input);
+    std::ostringstream encoded;
+    base64_encode(plain, encoded);
+    CHECK(encoded.str() == base64_encode(input));
+
+    std::istringstream encoded_in(encoded.str());
+    std::ostringstream decoded;
+    base64_decode(encoded_in, decoded);
+    CHECK(decoded.str() == input);
+
+    std::istringstream invalid("Zm9v\nYmFy");
+    std::ostringstream ignored;
+    CHECK_THROWS_AS(base64_decode(invalid, ignored), base64_error);
+}
+
+STUDENT_TEST("base64_encode_parallel matches base64_encode")
+{
+    // large enough to be split into many chunks
+    std::string input(3 * 1024 * 1024 + 2, '\0');
+    for (std::size_t i = 0; i != input.size(); ++i)
+    {
+        input[i] = static_cast<char>(i ^ (i >> 9));
+    }
+
+    for (std::size_t size : {std::size_t(100), input.size() - 2,
+             input.size() - 1, input.size()})
+    {
+        std::string const bytes = input.substr(0, size);
+        std::string const expected = base64_encode(bytes);
+        for (unsigned num_threads : {0u, 1u, 2u, 3u, 7u})
+        {
+            INFO("size: " << size << ", threads: " << num_threads);
+            REQUIRE(base64_encode_parallel(bytes, num_threads) == expected);
+        }
+    }
+}
+
+STUDENT_TEST("base64_encode_literal encodes at compile time")
+{
+    constexpr auto name = base64_encode_literal("Riley Oest");
+    static_assert(name.size() == 16);
+    static_assert(std::string_view(name.data(), name.size()) ==
+        "UmlsZXkgT2VzdA==");
+
+    constexpr auto empty = base64_encode_literal("");
+    static_assert(empty.size() == 0);
+
+    // bytes above 0x7f must not be sign extended
+    constexpr auto high = base64_encode_literal("\xff\xfe\x80");
+    static_assert(std::string_view(high.data(), high.size()) == "//6A");
+    CHECK(std::string_view(high.data(), high.size()) ==
+        base64_encode("\xff\xfe\x80"));
+}
+
+STUDENT_TEST("span overloads encode and decode into caller-provided buffers")
+{
+    std::byte const input[] = {std::byte{0x00}, std::byte{0xff},
+        std::byte{0x80}, std::byte{0x7f}, std::byte{0x10}};
+
+    char encoded[8];
+    REQUIRE(base64_encode(input, encoded) == 8);
+    CHECK(std::string_view(encoded, 8) == "AP+AfxA=");
+
+    std::byte decoded[6];
+    REQUIRE(base64_decode(std::span<char const>(encoded), decoded) == 5);
+    CHECK(std::equal(std::begin(input), std::end(input), decoded));
+
+    char too_small[7];
+    CHECK_THROWS_AS(base64_encode(input, too_small), std::runtime_error);
+
+    std::byte too_small_decoded[5];
+    CHECK_THROWS_AS(
+        base64_decode(std::span<char const>(encoded), too_small_decoded),
+        std::runtime_error);
+}
+
+STUDENT_TEST("URL-safe and MIME variants match the standard encoding")
+{
+    std::string input(2000, '\0');
+    unsigned state = 2023;
+    for (char& c : input)
+    {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+
+    CHECK(base64_url_encode("\xfb\xff\xbf") == "-_-_");
+    CHECK(base64_encode<base64_url_alphabet>("\xfb\xff", 4) == "-_8=");
+
+    for (base64_isa isa : {base64_isa::scalar, base64_isa::ssse3,
+             base64_isa::avx2, base64_isa::avx512})
+    {
+        if (!base64_isa_supported(isa))
+        {
+            continue;
+        }
+
+        INFO("isa: " << base64_isa_name(isa));
+        for (std::size_t size = 0; size <= 400; ++size)
+        {
+            std::string const bytes = input.substr(0, size);
+            std::string const standard =
+                base64_encode(bytes, base64_isa::scalar);
+
+            // URL-safe: the same, with '-' and '_' instead of '+' and '/'
+            std::string expected_url = standard;
+            std::replace(expected_url.begin(), expected_url.end(), '+', '-');
+            std::replace(expected_url.begin(), expected_url.end(), '/', '_');
+            REQUIRE(base64_encode<base64_url_alphabet>(bytes, 0, isa) ==
+                expected_url);
+
+            // MIME: the same, broken into lines of 76 characters
+            for (std::size_t line_length : {4, 8, 64, 76})
+            {
+                std::string expected_mime;
+                for (std::size_t pos = 0; pos < standard.size();
+                     pos += line_length)
+                {
+                    if (pos != 0)
+                    {
+                        expected_mime += "\r\n";
+                    }
+                    expected_mime += standard.substr(pos, line_length);
+                }
+                REQUIRE(base64_encode<base64_standard_alphabet>(
+                            bytes, line_length, isa) == expected_mime);
+                REQUIRE(expected_mime.size() ==
+                    base64_encoded_size(size, line_length));
+            }
+        }
+    }
+
+    CHECK(base64_mime_encode(input) ==
+        base64_encode<base64_standard_alphabet>(input, 76));
+    CHECK_THROWS_AS(
+        base64_encode<base64_standard_alphabet>(input, 75), std::runtime_error);
 }
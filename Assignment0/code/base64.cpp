@@ -0,0 +1,1123 @@
+// This file implements the interface declared in base64.hpp.
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define BASE64_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "base64.hpp"
+
+namespace {
+
+    constexpr unsigned char trailing_char = base64_trailing_char;
+
+    // All SIMD kernels encode as many full 3-byte groups as they can while
+    // staying inside the input buffer and return the number of input bytes
+    // they have consumed (always a multiple of 3). The caller encodes the
+    // remaining bytes using base64_encode_scalar.
+    using encode_kernel = std::size_t (*)(
+        unsigned char const* in, std::size_t in_len, char* out);
+
+    std::size_t encode_none(unsigned char const*, std::size_t, char*)
+    {
+        return 0;
+    }
+
+    // The line kernels encode whole lines of `line_length` characters, each
+    // followed by a CRLF, as long as there is more input after the line.
+    // The line breaks are stored by the same loop that stores the encoded
+    // blocks. They return the number of input bytes consumed (a multiple of
+    // the number of bytes per line), the caller encodes the rest.
+    using line_kernel = std::size_t (*)(unsigned char const* in,
+        std::size_t in_len, char* out, std::size_t line_length);
+
+    std::size_t encode_lines_none(
+        unsigned char const*, std::size_t, char*, std::size_t)
+    {
+        return 0;
+    }
+
+#if defined(BASE64_X86_KERNELS)
+    // The difference between the ASCII code of an encoded character and its
+    // 6-bit index, for each of the contiguous ranges of the alphabet. All
+    // alphabets are laid out as A-Z, a-z, 0-9 followed by two symbols.
+    template <typename Alphabet>
+    struct alphabet_offsets
+    {
+        static constexpr char upper = Alphabet::chars[0];
+        static constexpr char lower = Alphabet::chars[26] - 26;
+        static constexpr char digit = Alphabet::chars[52] - 52;
+        static constexpr char at_62 = Alphabet::chars[62] - 62;
+        static constexpr char at_63 = Alphabet::chars[63] - 63;
+    };
+
+    // Spread 12 input bytes (in the low bytes of each 128-bit lane) into 16
+    // 6-bit indices, one per output byte. Each 32-bit word receives the
+    // bytes [b, a, c, b] of one group, the multiplications then move the
+    // four 6-bit fields into place (see Wojciech Muła, "Base64 encoding
+    // with SIMD instructions").
+    __attribute__((target("ssse3"))) inline __m128i split_ssse3(__m128i in)
+    {
+        in = _mm_shuffle_epi8(in,
+            _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+        __m128i const t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        __m128i const t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        __m128i const t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        __m128i const t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        return _mm_or_si128(t1, t3);
+    }
+
+    // Translate 16 6-bit indices into ASCII. Each index is first reduced
+    // to the number of the range it falls into, which then selects the
+    // offset to add.
+    template <typename Alphabet>
+    __attribute__((target("ssse3"))) inline __m128i translate_ssse3(
+        __m128i indices)
+    {
+        using o = alphabet_offsets<Alphabet>;
+        __m128i const offsets = _mm_setr_epi8(o::lower, o::digit, o::digit,
+            o::digit, o::digit, o::digit, o::digit, o::digit, o::digit,
+            o::digit, o::digit, o::at_62, o::at_63, o::upper, 0, 0);
+
+        // 0 for [0, 51], 1..12 for [52, 63], then 13 for [0, 25]
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i const upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+        return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+    }
+
+    // Reads 16 bytes for each 12 bytes consumed.
+    template <typename Alphabet>
+    __attribute__((target("ssse3"))) std::size_t encode_ssse3(
+        unsigned char const* in, std::size_t in_len, char* out)
+    {
+        std::size_t pos = 0;
+        for (/**/; pos + 16 <= in_len; pos += 12, out += 16)
+        {
+            __m128i const bytes = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(in + pos));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                translate_ssse3<Alphabet>(split_ssse3(bytes)));
+        }
+        return pos;
+    }
+
+    // The last block of each line overlaps the one before it, which avoids
+    // falling back to the scalar loop for the end of the line. This reads
+    // up to 4 bytes past the end of the line.
+    template <typename Alphabet>
+    __attribute__((target("ssse3"))) std::size_t encode_lines_ssse3(
+        unsigned char const* in, std::size_t in_len, char* out,
+        std::size_t line_length)
+    {
+        std::size_t const line_bytes = line_length / 4 * 3;
+        if (line_bytes < 12)
+        {
+            return 0;
+        }
+
+        std::size_t pos = 0;
+        for (/**/; pos + line_bytes + 4 <= in_len;
+             pos += line_bytes, out += line_length + 2)
+        {
+            for (std::size_t i = 0; i < line_bytes; i += 12)
+            {
+                std::size_t const block = std::min(i, line_bytes - 12);
+                __m128i const bytes = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(in + pos + block));
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(out + block / 3 * 4),
+                    translate_ssse3<Alphabet>(split_ssse3(bytes)));
+            }
+            out[line_length] = '\r';
+            out[line_length + 1] = '\n';
+        }
+        return pos;
+    }
+
+    // Same as split_ssse3 for both 128-bit lanes.
+    __attribute__((target("avx2"))) inline __m256i split_avx2(__m256i in)
+    {
+        in = _mm256_shuffle_epi8(in,
+            _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11,
+                10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+        __m256i const t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i const t1 =
+            _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i const t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        __m256i const t3 =
+            _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        return _mm256_or_si256(t1, t3);
+    }
+
+    // Same as translate_ssse3 for both 128-bit lanes.
+    template <typename Alphabet>
+    __attribute__((target("avx2"))) inline __m256i translate_avx2(
+        __m256i indices)
+    {
+        using o = alphabet_offsets<Alphabet>;
+        __m256i const offsets = _mm256_setr_epi8(o::lower, o::digit, o::digit,
+            o::digit, o::digit, o::digit, o::digit, o::digit, o::digit,
+            o::digit, o::digit, o::at_62, o::at_63, o::upper, 0, 0, o::lower,
+            o::digit, o::digit, o::digit, o::digit, o::digit, o::digit,
+            o::digit, o::digit, o::digit, o::digit, o::at_62, o::at_63,
+            o::upper, 0, 0);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i const upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(
+            range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+
+        return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+    }
+
+    // Each lane is loaded separately (12 bytes apart), this reads 28 bytes
+    // for each 24 bytes consumed.
+    template <typename Alphabet>
+    __attribute__((target("avx2"))) std::size_t encode_avx2(
+        unsigned char const* in, std::size_t in_len, char* out)
+    {
+        std::size_t pos = 0;
+        for (/**/; pos + 28 <= in_len; pos += 24, out += 32)
+        {
+            __m128i const lo =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + pos));
+            __m128i const hi = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(in + pos + 12));
+            __m256i const bytes =
+                _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                translate_avx2<Alphabet>(split_avx2(bytes)));
+        }
+        return pos;
+    }
+
+    // Same as encode_lines_ssse3 using 24-byte blocks.
+    template <typename Alphabet>
+    __attribute__((target("avx2"))) std::size_t encode_lines_avx2(
+        unsigned char const* in, std::size_t in_len, char* out,
+        std::size_t line_length)
+    {
+        std::size_t const line_bytes = line_length / 4 * 3;
+        if (line_bytes < 24)
+        {
+            return 0;
+        }
+
+        std::size_t pos = 0;
+        for (/**/; pos + line_bytes + 4 <= in_len;
+             pos += line_bytes, out += line_length + 2)
+        {
+            for (std::size_t i = 0; i < line_bytes; i += 24)
+            {
+                std::size_t const block = std::min(i, line_bytes - 24);
+                __m128i const lo = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(in + pos + block));
+                __m128i const hi = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(in + pos + block + 12));
+                __m256i const bytes =
+                    _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i*>(out + block / 3 * 4),
+                    translate_avx2<Alphabet>(split_avx2(bytes)));
+            }
+            out[line_length] = '\r';
+            out[line_length + 1] = '\n';
+        }
+        return pos;
+    }
+
+    // AVX512-VBMI can do the whole job with three instructions: vpermb
+    // spreads the groups, vpmultishiftqb extracts the 6-bit fields, and a
+    // second vpermb looks them up in the (64 bytes wide) alphabet.
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) inline __m512i
+    encode_block_avx512(__m512i bytes, __m512i alphabet)
+    {
+        __m512i const spread = _mm512_setr_epi32(0x01020001, 0x04050304,
+            0x07080607, 0x0a0b090a, 0x0d0e0c0d, 0x10110f10, 0x13141213,
+            0x16171516, 0x191a1819, 0x1c1d1b1c, 0x1f201e1f, 0x22232122,
+            0x25262425, 0x28292728, 0x2b2c2a2b, 0x2e2f2d2e);
+        __m512i const shifts = _mm512_set1_epi64(0x3036242a1016040a);
+
+        __m512i const groups = _mm512_permutexvar_epi8(spread, bytes);
+        __m512i const indices = _mm512_multishift_epi64_epi8(shifts, groups);
+        return _mm512_permutexvar_epi8(indices, alphabet);
+    }
+
+    // Loads and stores are masked, so this never touches memory past the
+    // bytes it consumes and handles any number of full groups.
+    template <typename Alphabet>
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) std::size_t
+    encode_avx512(unsigned char const* in, std::size_t in_len, char* out)
+    {
+        __m512i const alphabet = _mm512_loadu_si512(Alphabet::chars);
+
+        std::size_t pos = 0;
+        for (/**/; pos + 48 <= in_len; pos += 48, out += 64)
+        {
+            __m512i const bytes =
+                _mm512_maskz_loadu_epi8(0x0000ffffffffffff, in + pos);
+            _mm512_storeu_si512(out, encode_block_avx512(bytes, alphabet));
+        }
+
+        // the remaining full groups (at most 15)
+        std::size_t groups = (in_len - pos) / 3;
+        if (groups != 0)
+        {
+            __mmask64 const load_mask = (1ull << (3 * groups)) - 1;
+            __mmask64 const store_mask = (1ull << (4 * groups)) - 1;
+            __m512i const bytes = _mm512_maskz_loadu_epi8(load_mask, in + pos);
+            _mm512_mask_storeu_epi8(
+                out, store_mask, encode_block_avx512(bytes, alphabet));
+            pos += 3 * groups;
+        }
+        return pos;
+    }
+
+    // Same as encode_lines_ssse3 using 48-byte blocks, lines shorter than a
+    // block are encoded using a masked load and store instead.
+    template <typename Alphabet>
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) std::size_t
+    encode_lines_avx512(unsigned char const* in, std::size_t in_len, char* out,
+        std::size_t line_length)
+    {
+        __m512i const alphabet = _mm512_loadu_si512(Alphabet::chars);
+
+        std::size_t const line_bytes = line_length / 4 * 3;
+        std::size_t const block_bytes = std::min<std::size_t>(line_bytes, 48);
+        __mmask64 const load_mask = (~0ull) >> (64 - block_bytes);
+        __mmask64 const store_mask = (~0ull) >> (64 - block_bytes / 3 * 4);
+
+        std::size_t pos = 0;
+        for (/**/; pos + line_bytes < in_len;
+             pos += line_bytes, out += line_length + 2)
+        {
+            for (std::size_t i = 0; i < line_bytes; i += block_bytes)
+            {
+                std::size_t const block = std::min(i, line_bytes - block_bytes);
+                __m512i const bytes =
+                    _mm512_maskz_loadu_epi8(load_mask, in + pos + block);
+                _mm512_mask_storeu_epi8(out + block / 3 * 4, store_mask,
+                    encode_block_avx512(bytes, alphabet));
+            }
+            out[line_length] = '\r';
+            out[line_length + 1] = '\n';
+        }
+        return pos;
+    }
+#endif
+
+    // Maps each character to its 6-bit index, all characters that are not
+    // part of the alphabet (including the padding) map to `invalid_char`.
+    constexpr unsigned char invalid_char = 0xff;
+
+    constexpr std::array<unsigned char, 256> make_decode_table()
+    {
+        std::array<unsigned char, 256> table{};
+        for (unsigned char& entry : table)
+        {
+            entry = invalid_char;
+        }
+        for (unsigned char i = 0; i != 64; ++i)
+        {
+            table[static_cast<unsigned char>(base64_chars[i])] = i;
+        }
+        return table;
+    }
+
+    constexpr std::array<unsigned char, 256> decode_table = make_decode_table();
+
+    // Decode full groups of 4 characters as long as they don't contain any
+    // invalid character (or padding). Returns the number of characters
+    // consumed, the decoding stops at the first group it can't handle.
+    std::size_t decode_groups_scalar(
+        unsigned char const* in, std::size_t in_len, unsigned char* out)
+    {
+        std::size_t pos = 0;
+        for (/**/; pos + 4 <= in_len; pos += 4, out += 3)
+        {
+            unsigned const a = decode_table[in[pos + 0]];
+            unsigned const b = decode_table[in[pos + 1]];
+            unsigned const c = decode_table[in[pos + 2]];
+            unsigned const d = decode_table[in[pos + 3]];
+            if ((a | b | c | d) == invalid_char)
+            {
+                break;
+            }
+
+            out[0] = static_cast<unsigned char>((a << 2) | (b >> 4));
+            out[1] = static_cast<unsigned char>((b << 4) | (c >> 2));
+            out[2] = static_cast<unsigned char>((c << 6) | d);
+        }
+        return pos;
+    }
+
+    // Decode the remaining characters one group at a time, handling the
+    // padding of the last group. Returns the number of bytes written, throws
+    // a base64_error pointing at the first offending character otherwise.
+    // `base` is the offset of `in` in the whole input.
+    std::size_t decode_tail(unsigned char const* in, std::size_t in_len,
+        unsigned char* out, std::size_t base)
+    {
+        std::size_t written = 0;
+        for (std::size_t pos = 0; pos < in_len; pos += 4)
+        {
+            unsigned char group[4] = {};
+            std::size_t i = 0;
+            for (/**/; i != 4 && pos + i < in_len; ++i)
+            {
+                if (in[pos + i] == trailing_char && i >= 2)
+                {
+                    break;    // start of the padding
+                }
+                group[i] = decode_table[in[pos + i]];
+                if (group[i] == invalid_char)
+                {
+                    throw base64_error(base + pos + i);
+                }
+            }
+
+            if (pos + i == in_len && i != 4)
+            {
+                throw base64_error(base + in_len);    // truncated input
+            }
+
+            out[written++] =
+                static_cast<unsigned char>((group[0] << 2) | (group[1] >> 4));
+            if (i == 4)
+            {
+                out[written++] = static_cast<unsigned char>(
+                    (group[1] << 4) | (group[2] >> 2));
+                out[written++] =
+                    static_cast<unsigned char>((group[2] << 6) | group[3]);
+                continue;
+            }
+
+            // the padding must not hide any bits that are set
+            if (i == 2 && (group[1] & 0x0f) != 0)
+            {
+                throw base64_error(base + pos + 2);
+            }
+            if (i == 3)
+            {
+                if ((group[2] & 0x03) != 0)
+                {
+                    throw base64_error(base + pos + 3);
+                }
+                out[written++] = static_cast<unsigned char>(
+                    (group[1] << 4) | (group[2] >> 2));
+            }
+
+            // the padding completes the group and ends the input
+            if (i == 2)
+            {
+                if (pos + 3 == in_len)
+                {
+                    throw base64_error(base + in_len);
+                }
+                if (in[pos + 3] != trailing_char)
+                {
+                    throw base64_error(base + pos + 3);
+                }
+            }
+            if (pos + 4 != in_len)
+            {
+                throw base64_error(base + pos + 4);
+            }
+        }
+        return written;
+    }
+
+    // The SIMD decoders translate and validate full groups while staying
+    // inside the input buffer. They return the number of characters they
+    // have consumed (always a multiple of 4) and stop at the first block
+    // that contains anything but alphabet characters, which leaves the
+    // error reporting to the scalar code.
+    using decode_kernel = std::size_t (*)(
+        unsigned char const* in, std::size_t in_len, unsigned char* out);
+
+    std::size_t decode_none(unsigned char const*, std::size_t, unsigned char*)
+    {
+        return 0;
+    }
+
+#if defined(BASE64_X86_KERNELS)
+    // Translates and validates 32 characters at a time using nibble lookup
+    // tables (see Wojciech Muła, Daniel Lemire, "Faster Base64 Encoding and
+    // Decoding using AVX2 Instructions"). The tables are specific to the
+    // standard alphabet.
+    __attribute__((target("avx2"))) std::size_t decode_avx2(
+        unsigned char const* in, std::size_t in_len, unsigned char* out)
+    {
+        // bit set in lut_lo[lo] & lut_hi[hi] <=> character is invalid
+        __m256i const lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+            0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        __m256i const lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04,
+            0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x10, 0x10, 0x10);
+        // offset to add to each character, selected by its high nibble
+        __m256i const lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71,
+            -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0,
+            0, 0, 0, 0, 0, 0);
+        __m256i const mask_2f = _mm256_set1_epi8(0x2f);
+
+        // gathers the 3 bytes of each 32-bit word, then the 6 words
+        __m256i const pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+            13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1,
+            -1, -1, -1);
+        __m256i const pack_lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+        std::size_t pos = 0;
+        for (/**/; pos + 32 <= in_len; pos += 32, out += 24)
+        {
+            __m256i str =
+                _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + pos));
+
+            __m256i const hi_nibbles =
+                _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+            __m256i const lo_nibbles = _mm256_and_si256(str, mask_2f);
+            __m256i const lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+            __m256i const hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+            if (!_mm256_testz_si256(lo, hi))
+            {
+                break;
+            }
+
+            __m256i const eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+            __m256i const roll = _mm256_shuffle_epi8(
+                lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+            str = _mm256_add_epi8(str, roll);
+
+            // merge the 6-bit values into 24-bit words
+            __m256i const merged_ab_cd =
+                _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+            __m256i const merged =
+                _mm256_madd_epi16(merged_ab_cd, _mm256_set1_epi32(0x00011000));
+            __m256i const packed = _mm256_permutevar8x32_epi32(
+                _mm256_shuffle_epi8(merged, pack), pack_lanes);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                _mm256_castsi256_si128(packed));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16),
+                _mm256_extracti128_si256(packed, 1));
+        }
+        return pos;
+    }
+
+    // Translates 64 characters at a time by looking them up in the lower
+    // half of the decode table with vpermi2b. Any invalid character has the
+    // high bit set either in its code or in its translation.
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) std::size_t
+    decode_avx512(
+        unsigned char const* in, std::size_t in_len, unsigned char* out)
+    {
+        __m512i const lookup_lo = _mm512_loadu_si512(decode_table.data());
+        __m512i const lookup_hi = _mm512_loadu_si512(decode_table.data() + 64);
+        __m512i const pack = _mm512_setr_epi32(0x06000102, 0x090a0405,
+            0x0c0d0e08, 0x16101112, 0x191a1415, 0x1c1d1e18, 0x26202122,
+            0x292a2425, 0x2c2d2e28, 0x36303132, 0x393a3435, 0x3c3d3e38, 0, 0,
+            0, 0);
+
+        std::size_t pos = 0;
+        for (/**/; pos + 64 <= in_len; pos += 64, out += 48)
+        {
+            __m512i const str = _mm512_loadu_si512(in + pos);
+            __m512i const values =
+                _mm512_permutex2var_epi8(lookup_lo, str, lookup_hi);
+            if (_mm512_movepi8_mask(_mm512_or_si512(values, str)) != 0)
+            {
+                break;
+            }
+
+            __m512i const merged_ab_cd =
+                _mm512_maddubs_epi16(values, _mm512_set1_epi32(0x01400140));
+            __m512i const merged =
+                _mm512_madd_epi16(merged_ab_cd, _mm512_set1_epi32(0x00011000));
+            _mm512_mask_storeu_epi8(out, 0x0000ffffffffffff,
+                _mm512_permutexvar_epi8(pack, merged));
+        }
+        return pos;
+    }
+#endif
+
+    template <typename Alphabet>
+    encode_kernel kernel_for(base64_isa isa)
+    {
+        switch (isa)
+        {
+#if defined(BASE64_X86_KERNELS)
+        case base64_isa::ssse3:
+            return encode_ssse3<Alphabet>;
+        case base64_isa::avx2:
+            return encode_avx2<Alphabet>;
+        case base64_isa::avx512:
+            return encode_avx512<Alphabet>;
+#endif
+        default:
+            break;
+        }
+        return encode_none;
+    }
+
+    template <typename Alphabet>
+    line_kernel line_kernel_for(base64_isa isa)
+    {
+        switch (isa)
+        {
+#if defined(BASE64_X86_KERNELS)
+        case base64_isa::ssse3:
+            return encode_lines_ssse3<Alphabet>;
+        case base64_isa::avx2:
+            return encode_lines_avx2<Alphabet>;
+        case base64_isa::avx512:
+            return encode_lines_avx512<Alphabet>;
+#endif
+        default:
+            break;
+        }
+        return encode_lines_none;
+    }
+
+    // Encode `in_len` bytes, the kernel handles the bulk of the input and
+    // the scalar loop the rest. Returns the number of characters written.
+    template <typename Alphabet>
+    std::size_t encode_bytes(encode_kernel kernel, unsigned char const* in,
+        std::size_t in_len, char* out)
+    {
+        std::size_t pos = kernel(in, in_len, out);
+        base64_encode_scalar<Alphabet>(
+            in + pos, in_len - pos, out + pos / 3 * 4);
+        return base64_encoded_size(in_len);
+    }
+
+    // Same as encode_bytes, inserting a CRLF after every `line_length`
+    // characters (a multiple of 4, 0 disables the line breaks). The line
+    // kernel handles all but the last few lines, which are encoded one at a
+    // time straight into their place in the output.
+    template <typename Alphabet>
+    std::size_t encode_lines(base64_isa isa, unsigned char const* in,
+        std::size_t in_len, char* out, std::size_t line_length)
+    {
+        encode_kernel kernel = kernel_for<Alphabet>(isa);
+        if (line_length == 0)
+        {
+            return encode_bytes<Alphabet>(kernel, in, in_len, out);
+        }
+
+        std::size_t bytes_per_line = line_length / 4 * 3;
+        std::size_t start =
+            line_kernel_for<Alphabet>(isa)(in, in_len, out, line_length);
+
+        char* dest = out + start / bytes_per_line * (line_length + 2);
+        for (std::size_t pos = start; pos < in_len; pos += bytes_per_line)
+        {
+            if (pos != start)
+            {
+                *dest++ = '\r';
+                *dest++ = '\n';
+            }
+            std::size_t len = std::min(bytes_per_line, in_len - pos);
+            dest += encode_bytes<Alphabet>(kernel, in + pos, len, dest);
+        }
+        return static_cast<std::size_t>(dest - out);
+    }
+
+    base64_isa best_isa()
+    {
+        static base64_isa const isa = base64_detect_isa();
+        return isa;
+    }
+
+    template <typename Alphabet>
+    encode_kernel best_encode_kernel()
+    {
+        static encode_kernel const kernel = kernel_for<Alphabet>(best_isa());
+        return kernel;
+    }
+
+    template <typename Alphabet>
+    std::string encode(std::string const& bytes_to_encode, base64_isa isa,
+        std::size_t line_length = 0)
+    {
+        if (line_length % 4 != 0)
+        {
+            throw std::runtime_error(
+                "base64_encode: line length must be a multiple of 4");
+        }
+
+        std::string ret(
+            base64_encoded_size(bytes_to_encode.size(), line_length), '\0');
+        encode_lines<Alphabet>(isa,
+            reinterpret_cast<unsigned char const*>(bytes_to_encode.data()),
+            bytes_to_encode.size(), ret.data(), line_length);
+        return ret;
+    }
+
+    decode_kernel decode_kernel_for(base64_isa isa)
+    {
+        switch (isa)
+        {
+#if defined(BASE64_X86_KERNELS)
+        case base64_isa::avx2:
+            return decode_avx2;
+        case base64_isa::avx512:
+            return decode_avx512;
+#endif
+        default:
+            break;
+        }
+        return decode_none;
+    }
+
+    // Decode `in_len` characters, `base` is the offset of `in` in the whole
+    // input (used for error reporting). Returns the number of bytes written.
+    std::size_t decode_chars(decode_kernel kernel, unsigned char const* in,
+        std::size_t in_len, unsigned char* out, std::size_t base)
+    {
+        // the last group may be padded, leave it to decode_tail
+        std::size_t body_len = in_len == 0 ? 0 : (in_len - 1) / 4 * 4;
+
+        std::size_t pos = kernel(in, body_len, out);
+        pos +=
+            decode_groups_scalar(in + pos, body_len - pos, out + pos / 4 * 3);
+
+        std::size_t written = pos / 4 * 3;
+        return written +
+            decode_tail(in + pos, in_len - pos, out + written, base + pos);
+    }
+
+    decode_kernel best_decode_kernel()
+    {
+        static decode_kernel const kernel = decode_kernel_for(best_isa());
+        return kernel;
+    }
+
+    std::string decode(std::string const& encoded, decode_kernel kernel)
+    {
+        std::string ret(base64_decoded_size(encoded.size()), '\0');
+        std::size_t written = decode_chars(kernel,
+            reinterpret_cast<unsigned char const*>(encoded.data()),
+            encoded.size(), reinterpret_cast<unsigned char*>(ret.data()), 0);
+        ret.resize(written);
+        return ret;
+    }
+
+    // The parallel encoder hands out chunks of this many input bytes to its
+    // threads, inputs smaller than parallel_threshold are not worth it.
+    constexpr std::size_t parallel_chunk_size = 3 * 65536;
+    constexpr std::size_t parallel_threshold = 4 * parallel_chunk_size;
+
+    // The stream functions work on chunks of this size, which bounds their
+    // memory use no matter how large the input is.
+    constexpr std::size_t stream_chunk_size = 3 * 4096;
+}    // namespace
+
+namespace {
+
+    void check_supported(base64_isa isa)
+    {
+        if (!base64_isa_supported(isa))
+        {
+            throw std::runtime_error(
+                std::string("instruction set not supported: ") +
+                base64_isa_name(isa));
+        }
+    }
+}    // namespace
+
+base64_error::base64_error(std::size_t offset)
+  : std::runtime_error(
+        "invalid base64 input at offset " + std::to_string(offset))
+  , error_offset(offset)
+{
+}
+
+base64_isa base64_detect_isa()
+{
+#if defined(BASE64_X86_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vbmi"))
+    {
+        return base64_isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return base64_isa::avx2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return base64_isa::ssse3;
+    }
+#endif
+    return base64_isa::scalar;
+}
+
+bool base64_isa_supported(base64_isa isa)
+{
+    // each of the kernels requires a superset of the previous ones
+    return isa <= best_isa();
+}
+
+char const* base64_isa_name(base64_isa isa)
+{
+    switch (isa)
+    {
+    case base64_isa::ssse3:
+        return "ssse3";
+    case base64_isa::avx2:
+        return "avx2";
+    case base64_isa::avx512:
+        return "avx512";
+    default:
+        break;
+    }
+    return "scalar";
+}
+
+std::string base64_encode(std::string const& bytes_to_encode)
+{
+    return encode<base64_standard_alphabet>(bytes_to_encode, best_isa());
+}
+
+template <typename Alphabet>
+std::string base64_encode(
+    std::string const& bytes_to_encode, std::size_t line_length)
+{
+    return encode<Alphabet>(bytes_to_encode, best_isa(), line_length);
+}
+
+template <typename Alphabet>
+std::string base64_encode(std::string const& bytes_to_encode,
+    std::size_t line_length, base64_isa isa)
+{
+    check_supported(isa);
+    return encode<Alphabet>(bytes_to_encode, isa, line_length);
+}
+
+template std::string base64_encode<base64_standard_alphabet>(
+    std::string const&, std::size_t);
+template std::string base64_encode<base64_url_alphabet>(
+    std::string const&, std::size_t);
+template std::string base64_encode<base64_standard_alphabet>(
+    std::string const&, std::size_t, base64_isa);
+template std::string base64_encode<base64_url_alphabet>(
+    std::string const&, std::size_t, base64_isa);
+
+std::size_t base64_encode(std::span<std::byte const> in, std::span<char> out)
+{
+    return base64_encode(in, out, best_isa());
+}
+
+std::size_t base64_encode(
+    std::span<std::byte const> in, std::span<char> out, base64_isa isa)
+{
+    check_supported(isa);
+    if (out.size() < base64_encoded_size(in.size()))
+    {
+        throw std::runtime_error("base64_encode: output buffer too small");
+    }
+    return encode_bytes<base64_standard_alphabet>(
+        kernel_for<base64_standard_alphabet>(isa),
+        reinterpret_cast<unsigned char const*>(in.data()), in.size(),
+        out.data());
+}
+
+std::string base64_encode(std::string const& bytes_to_encode, base64_isa isa)
+{
+    check_supported(isa);
+    return encode<base64_standard_alphabet>(bytes_to_encode, isa);
+}
+
+std::string base64_decode(std::string const& encoded)
+{
+    return decode(encoded, best_decode_kernel());
+}
+
+std::size_t base64_decode(std::span<char const> in, std::span<std::byte> out)
+{
+    return base64_decode(in, out, best_isa());
+}
+
+std::size_t base64_decode(
+    std::span<char const> in, std::span<std::byte> out, base64_isa isa)
+{
+    check_supported(isa);
+    if (out.size() < base64_decoded_size(in.size()))
+    {
+        throw std::runtime_error("base64_decode: output buffer too small");
+    }
+    return decode_chars(decode_kernel_for(isa),
+        reinterpret_cast<unsigned char const*>(in.data()), in.size(),
+        reinterpret_cast<unsigned char*>(out.data()), 0);
+}
+
+std::string base64_decode(std::string const& encoded, base64_isa isa)
+{
+    check_supported(isa);
+    return decode(encoded, decode_kernel_for(isa));
+}
+
+std::string base64_encode_parallel(
+    std::string const& bytes_to_encode, unsigned num_threads)
+{
+    std::size_t in_len = bytes_to_encode.size();
+    if (num_threads == 1 || in_len < parallel_threshold)
+    {
+        return base64_encode(bytes_to_encode);
+    }
+    if (num_threads == 0)
+    {
+        // querying this is not free, cache it
+        static unsigned const hardware_threads =
+            std::max(std::thread::hardware_concurrency(), 1u);
+        num_threads = hardware_threads;
+    }
+
+    std::string ret(base64_encoded_size(in_len), '\0');
+
+    auto const* in =
+        reinterpret_cast<unsigned char const*>(bytes_to_encode.data());
+    char* out = ret.data();
+    encode_kernel kernel = best_encode_kernel<base64_standard_alphabet>();
+
+    // the threads grab the next chunk as soon as they are done with the
+    // previous one, the last chunk holds the (padded) tail of the input
+    std::size_t num_chunks =
+        (in_len + parallel_chunk_size - 1) / parallel_chunk_size;
+    std::atomic<std::size_t> next_chunk(0);
+
+    auto worker = [&]() {
+        for (std::size_t chunk = next_chunk++; chunk < num_chunks;
+             chunk = next_chunk++)
+        {
+            std::size_t pos = chunk * parallel_chunk_size;
+            std::size_t len = std::min(parallel_chunk_size, in_len - pos);
+            encode_bytes<base64_standard_alphabet>(
+                kernel, in + pos, len, out + pos / 3 * 4);
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        num_threads = static_cast<unsigned>(
+            std::min<std::size_t>(num_threads, num_chunks));
+        for (unsigned i = 1; i != num_threads; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+    }    // joins all threads
+
+    return ret;
+}
+
+std::size_t base64_encoder::update(
+    std::span<std::byte const> in, std::span<char> out)
+{
+    if (out.size() < max_output_size(in.size()))
+    {
+        throw std::runtime_error("base64_encoder: output buffer too small");
+    }
+
+    auto const* bytes = reinterpret_cast<unsigned char const*>(in.data());
+    std::size_t in_len = in.size();
+    char* dest = out.data();
+
+    // complete the group left over from the previous call
+    if (num_pending != 0)
+    {
+        while (num_pending != 3 && in_len != 0)
+        {
+            pending[num_pending++] = *bytes++;
+            --in_len;
+        }
+        if (num_pending != 3)
+        {
+            return 0;
+        }
+        base64_encode_scalar<base64_standard_alphabet>(pending, 3, dest);
+        dest += 4;
+        num_pending = 0;
+    }
+
+    std::size_t full = in_len / 3 * 3;
+    dest += encode_bytes<base64_standard_alphabet>(
+        best_encode_kernel<base64_standard_alphabet>(), bytes, full, dest);
+
+    for (/**/; full != in_len; ++full)
+    {
+        pending[num_pending++] = bytes[full];
+    }
+    return static_cast<std::size_t>(dest - out.data());
+}
+
+void base64_encoder::update(std::span<std::byte const> in, std::ostream& out)
+{
+    char buffer[stream_chunk_size / 3 * 4 + 4];
+    while (!in.empty())
+    {
+        std::size_t chunk = std::min(in.size(), stream_chunk_size);
+        std::size_t written = update(in.first(chunk), buffer);
+        out.write(buffer, static_cast<std::streamsize>(written));
+        in = in.subspan(chunk);
+    }
+}
+
+std::size_t base64_encoder::finish(std::span<char> out)
+{
+    if (out.size() < 4 && num_pending != 0)
+    {
+        throw std::runtime_error("base64_encoder: output buffer too small");
+    }
+
+    std::size_t written = base64_encoded_size(num_pending);
+    base64_encode_scalar<base64_standard_alphabet>(
+        pending, num_pending, out.data());
+    num_pending = 0;
+    return written;
+}
+
+void base64_encoder::finish(std::ostream& out)
+{
+    char buffer[4];
+    out.write(buffer, static_cast<std::streamsize>(finish(buffer)));
+}
+
+std::size_t base64_decoder::update(
+    std::span<char const> in, std::span<std::byte> out)
+{
+    if (out.size() < max_output_size(in.size()))
+    {
+        throw std::runtime_error("base64_decoder: output buffer too small");
+    }
+    if (padded && !in.empty())
+    {
+        throw base64_error(consumed);    // data following the padding
+    }
+
+    auto const* chars = reinterpret_cast<unsigned char const*>(in.data());
+    std::size_t in_len = in.size();
+    auto* dest = reinterpret_cast<unsigned char*>(out.data());
+    std::size_t written = 0;
+
+    // complete the group left over from the previous call
+    if (num_pending != 0)
+    {
+        while (num_pending != 4 && in_len != 0)
+        {
+            pending[num_pending++] = *chars++;
+            --in_len;
+        }
+        if (num_pending != 4)
+        {
+            return 0;
+        }
+        written =
+            decode_chars(best_decode_kernel(), pending, 4, dest, consumed);
+        consumed += 4;
+        num_pending = 0;
+        padded = written != 3;
+    }
+
+    std::size_t full = in_len / 4 * 4;
+    if (full != 0)
+    {
+        if (padded)
+        {
+            throw base64_error(consumed);
+        }
+
+        std::size_t n = decode_chars(
+            best_decode_kernel(), chars, full, dest + written, consumed);
+        consumed += full;
+        written += n;
+        padded = n != full / 4 * 3;
+    }
+
+    if (full != in_len && padded)
+    {
+        throw base64_error(consumed);
+    }
+    for (/**/; full != in_len; ++full)
+    {
+        pending[num_pending++] = chars[full];
+    }
+    return written;
+}
+
+void base64_decoder::update(std::span<char const> in, std::ostream& out)
+{
+    char buffer[stream_chunk_size + 3];
+    while (!in.empty())
+    {
+        std::size_t chunk = std::min(in.size(), stream_chunk_size / 3 * 4);
+        std::size_t written =
+            update(in.first(chunk), std::as_writable_bytes(std::span(buffer)));
+        out.write(buffer, static_cast<std::streamsize>(written));
+        in = in.subspan(chunk);
+    }
+}
+
+void base64_decoder::finish()
+{
+    std::size_t offset = consumed + num_pending;
+    bool truncated = num_pending != 0;
+
+    num_pending = 0;
+    consumed = 0;
+    padded = false;
+
+    if (truncated)
+    {
+        throw base64_error(offset);
+    }
+}
+
+void base64_encode(std::istream& in, std::ostream& out)
+{
+    base64_encoder encoder;
+    char buffer[stream_chunk_size];
+    while (in)
+    {
+        in.read(buffer, stream_chunk_size);
+        std::span<char const> chunk(
+            buffer, static_cast<std::size_t>(in.gcount()));
+        encoder.update(std::as_bytes(chunk), out);
+    }
+    encoder.finish(out);
+}
+
+void base64_decode(std::istream& in, std::ostream& out)
+{
+    base64_decoder decoder;
+    char buffer[stream_chunk_size / 3 * 4];
+    while (in)
+    {
+        in.read(buffer, sizeof(buffer));
+        decoder.update(std::span<char const>(buffer,
+                           static_cast<std::size_t>(in.gcount())),
+            out);
+    }
+    decoder.finish();
+}
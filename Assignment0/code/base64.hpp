@@ -0,0 +1,312 @@
+// This file declares the base64 encoder and decoder. The bulk of the input
+// is handled by SIMD kernels that are selected at runtime based on what the
+// CPU we're running on supports, the remaining bytes by a scalar loop.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// This code is taken from: https://github.com/ReneNyffenegger.
+// The code was distributed under the LICENSE:
+// https://github.com/ReneNyffenegger/cpp-base64/blob/master/LICENSE
+
+constexpr char const* base64_chars = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+constexpr char base64_trailing_char = '=';
+
+// The alphabets the encoder supports, passed as a template parameter. Each
+// is laid out as A-Z, a-z, 0-9 followed by two symbols.
+struct base64_standard_alphabet
+{
+    static constexpr char const* chars = base64_chars;
+};
+
+// RFC 4648, section 5: safe to use in URLs and file names.
+struct base64_url_alphabet
+{
+    static constexpr char const* chars =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+};
+
+// RFC 2045 (MIME) limits encoded lines to 76 characters.
+constexpr std::size_t base64_mime_line_length = 76;
+
+// The instruction set extensions the encoder knows how to use. The wider
+// kernels consume more input bytes per iteration.
+enum class base64_isa
+{
+    scalar = 0,    // portable code, one 3-byte group at a time
+    ssse3 = 1,     // 12 input bytes per iteration
+    avx2 = 2,      // 24 input bytes per iteration
+    avx512 = 3     // 48 input bytes per iteration (AVX512-VBMI)
+};
+
+// Returns the widest instruction set that is supported by the CPU (and the
+// operating system) this program is running on.
+base64_isa base64_detect_isa();
+
+// Returns whether the given instruction set can be used on this machine.
+bool base64_isa_supported(base64_isa isa);
+
+// Returns the name of the given instruction set, e.g. "avx2".
+char const* base64_isa_name(base64_isa isa);
+
+// Returns the number of characters needed to encode `in_len` bytes.
+constexpr std::size_t base64_encoded_size(std::size_t in_len)
+{
+    return (in_len + 2) / 3 * 4;
+}
+
+// Returns the number of characters needed to encode `in_len` bytes with a
+// CRLF after every `line_length` characters (0 means no line breaks).
+constexpr std::size_t base64_encoded_size(
+    std::size_t in_len, std::size_t line_length)
+{
+    std::size_t chars = base64_encoded_size(in_len);
+    if (line_length == 0 || chars == 0)
+    {
+        return chars;
+    }
+    return chars + (chars - 1) / line_length * 2;
+}
+
+// Encode `in_len` bytes one 3-byte group at a time, the last group is padded
+// with `base64_trailing_char` if needed. `Byte` may be any of the character
+// types or std::byte, the bytes are always treated as unsigned. This is the
+// portable fallback used for whatever the SIMD kernels leave behind, it can
+// also be evaluated at compile time. Returns the end of the output.
+template <typename Alphabet = base64_standard_alphabet, typename Byte>
+constexpr char* base64_encode_scalar(
+    Byte const* in, std::size_t in_len, char* out)
+{
+    std::size_t pos = 0;
+
+    while (pos < in_len)
+    {
+        unsigned char const b0 = static_cast<unsigned char>(in[pos + 0]);
+        *out++ = Alphabet::chars[(b0 & 0xfc) >> 2];
+        if (pos + 1 < in_len)
+        {
+            unsigned char const b1 = static_cast<unsigned char>(in[pos + 1]);
+            *out++ = Alphabet::chars[((b0 & 0x03) << 4) + ((b1 & 0xf0) >> 4)];
+
+            if (pos + 2 < in_len)
+            {
+                unsigned char const b2 =
+                    static_cast<unsigned char>(in[pos + 2]);
+                *out++ =
+                    Alphabet::chars[((b1 & 0x0f) << 2) + ((b2 & 0xc0) >> 6)];
+                *out++ = Alphabet::chars[b2 & 0x3f];
+            }
+            else
+            {
+                *out++ = Alphabet::chars[(b1 & 0x0f) << 2];
+                *out++ = base64_trailing_char;
+            }
+        }
+        else
+        {
+            *out++ = Alphabet::chars[(b0 & 0x03) << 4];
+            *out++ = base64_trailing_char;
+            *out++ = base64_trailing_char;
+        }
+        pos += 3;
+    }
+    return out;
+}
+
+// Calculate the base64 encoding of a string literal at compile time, e.g.
+//
+//     constexpr auto header = base64_encode_literal("user:password");
+//
+// The terminating '\0' of the literal is not encoded and the result does not
+// hold one either.
+template <std::size_t N>
+constexpr std::array<char, base64_encoded_size(N - 1)> base64_encode_literal(
+    char const (&literal)[N])
+{
+    std::array<char, base64_encoded_size(N - 1)> result{};
+    base64_encode_scalar(literal, N - 1, result.data());
+    return result;
+}
+
+// Calculate the base64 encoding of the given bytes using the best kernel
+// available on this machine.
+std::string base64_encode(std::string const& bytes_to_encode);
+
+// Calculate the base64 encoding of the given bytes using the given alphabet
+// and the best kernel available on this machine. If `line_length` is not
+// zero (it has to be a multiple of 4) a CRLF is inserted after every
+// `line_length` characters. The line breaks are written by the same loop
+// that stores the encoded characters, there is no second pass over the
+// result.
+template <typename Alphabet>
+std::string base64_encode(
+    std::string const& bytes_to_encode, std::size_t line_length = 0);
+
+// Same as above, using the kernel for the given instruction set. Throws a
+// std::runtime_error if the instruction set is not supported by this machine.
+template <typename Alphabet>
+std::string base64_encode(std::string const& bytes_to_encode,
+    std::size_t line_length, base64_isa isa);
+
+// Calculate the URL-safe (RFC 4648) base64 encoding of the given bytes.
+inline std::string base64_url_encode(std::string const& bytes_to_encode)
+{
+    return base64_encode<base64_url_alphabet>(bytes_to_encode);
+}
+
+// Calculate the MIME (RFC 2045) base64 encoding of the given bytes, lines are
+// separated by CRLF.
+inline std::string base64_mime_encode(std::string const& bytes_to_encode)
+{
+    return base64_encode<base64_standard_alphabet>(
+        bytes_to_encode, base64_mime_line_length);
+}
+
+// Encode the given bytes into `out` without allocating any memory. `out`
+// needs room for base64_encoded_size(in.size()) characters, a
+// std::runtime_error is thrown otherwise. Returns the number of characters
+// written.
+std::size_t base64_encode(std::span<std::byte const> in, std::span<char> out);
+
+// Same as above, using the kernel for the given instruction set. Throws a
+// std::runtime_error if the instruction set is not supported by this machine.
+std::size_t base64_encode(std::span<std::byte const> in, std::span<char> out,
+    base64_isa isa);
+
+// Calculate the base64 encoding of the given bytes using the kernel for the
+// given instruction set. Throws a std::runtime_error if the instruction set
+// is not supported by this machine.
+std::string base64_encode(std::string const& bytes_to_encode, base64_isa isa);
+
+// Calculate the base64 encoding of the given bytes using up to `num_threads`
+// threads (0 selects std::thread::hardware_concurrency). The input is split
+// into chunks on 3-byte boundaries that are encoded concurrently, each of
+// them directly into its place in the result. Inputs too small to benefit
+// are encoded by the calling thread only.
+std::string base64_encode_parallel(
+    std::string const& bytes_to_encode, unsigned num_threads = 0);
+
+// The exception thrown by base64_decode if its input is not valid base64.
+// offset() is the position of the first byte at which the input stops being
+// the beginning of a valid encoding: a character that is not part of the
+// alphabet, misplaced padding, padding that hides non-zero bits, any byte
+// following the padding, or the end of a truncated input.
+class base64_error : public std::runtime_error
+{
+    std::size_t error_offset;
+
+public:
+    explicit base64_error(std::size_t offset);
+
+    std::size_t offset() const
+    {
+        return error_offset;
+    }
+};
+
+// Returns the maximum number of bytes `in_len` characters decode to.
+constexpr std::size_t base64_decoded_size(std::size_t in_len)
+{
+    return in_len / 4 * 3;
+}
+
+// Decode the given base64 string using the best kernel available on this
+// machine. Throws a base64_error if the input is not valid.
+std::string base64_decode(std::string const& encoded);
+
+// Decode the given characters into `out` without allocating any memory.
+// `out` needs room for base64_decoded_size(in.size()) bytes, a
+// std::runtime_error is thrown otherwise. Returns the number of bytes
+// written, throws a base64_error if the input is not valid.
+std::size_t base64_decode(std::span<char const> in, std::span<std::byte> out);
+
+// Same as above, using the kernel for the given instruction set. Throws a
+// std::runtime_error if the instruction set is not supported by this machine.
+std::size_t base64_decode(std::span<char const> in, std::span<std::byte> out,
+    base64_isa isa);
+
+// Decode the given base64 string using the kernel for the given instruction
+// set. There is no SSSE3 decoder, it falls back to the scalar loop.
+std::string base64_decode(std::string const& encoded, base64_isa isa);
+
+// Incrementally encodes a sequence of chunks of bytes. The encoder carries
+// the 0-2 bytes of an incomplete group from one update to the next, so its
+// memory use does not depend on the size of the input.
+class base64_encoder
+{
+    unsigned char pending[3] = {};
+    std::size_t num_pending = 0;
+
+public:
+    // Returns the maximum number of characters the next update writes when
+    // given `in_len` bytes.
+    std::size_t max_output_size(std::size_t in_len) const
+    {
+        return (num_pending + in_len) / 3 * 4;
+    }
+
+    // Encode the given bytes, writing the characters of all groups that are
+    // complete to `out`. Returns the number of characters written. Throws a
+    // std::runtime_error if `out` is smaller than max_output_size.
+    std::size_t update(std::span<std::byte const> in, std::span<char> out);
+
+    // Same as above, writing the characters to the given stream.
+    void update(std::span<std::byte const> in, std::ostream& out);
+
+    // Write the (padded) last group, if any, and reset the encoder. `out`
+    // needs room for 4 characters. Returns the number of characters written.
+    std::size_t finish(std::span<char> out);
+
+    // Same as above, writing the characters to the given stream.
+    void finish(std::ostream& out);
+};
+
+// Incrementally decodes a sequence of chunks of characters. The decoder
+// carries the 0-3 characters of an incomplete group from one update to the
+// next, so its memory use does not depend on the size of the input. Errors
+// are reported as a base64_error with the offset counted from the start of
+// the first chunk.
+class base64_decoder
+{
+    unsigned char pending[4] = {};
+    std::size_t num_pending = 0;
+    std::size_t consumed = 0;    // number of characters decoded so far
+    bool padded = false;         // the last group decoded was padded
+
+public:
+    // Returns the maximum number of bytes the next update writes when given
+    // `in_len` characters.
+    std::size_t max_output_size(std::size_t in_len) const
+    {
+        return (num_pending + in_len) / 4 * 3;
+    }
+
+    // Decode the given characters, writing the bytes of all groups that are
+    // complete to `out`. Returns the number of bytes written. Throws a
+    // std::runtime_error if `out` is smaller than max_output_size.
+    std::size_t update(std::span<char const> in, std::span<std::byte> out);
+
+    // Same as above, writing the bytes to the given stream.
+    void update(std::span<char const> in, std::ostream& out);
+
+    // Check that the input did not end in the middle of a group and reset the
+    // decoder. Throws a base64_error otherwise.
+    void finish();
+};
+
+// Encode everything that can be read from `in`, writing the characters to
+// `out`. This uses a fixed amount of memory, no matter how large the input.
+void base64_encode(std::istream& in, std::ostream& out);
+
+// Decode everything that can be read from `in`, writing the bytes to `out`.
+// This uses a fixed amount of memory, no matter how large the input. Throws
+// a base64_error if the input is not valid.
+void base64_decode(std::istream& in, std::ostream& out);
@@ -0,0 +1,280 @@
+// Benchmarks for the base64 encoder and decoder. Each benchmark reports its
+// throughput in GB/s (of unencoded data) after Catch's timing results.
+//
+// The default run covers inputs from 16 B to 1 MiB, the larger ones (up to
+// 1 GiB) are hidden and can be run with:
+//
+//     base64_benchmark "[large]"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "base64.hpp"
+
+// Maps the name of each benchmark to the number of bytes it processes per
+// run, which lets the listener below turn the mean time into a throughput.
+std::map<std::string, std::size_t>& benchmark_bytes()
+{
+    static std::map<std::string, std::size_t> bytes;
+    return bytes;
+}
+
+// Collects the throughput of all benchmarks in a test case and prints them
+// once the test case has finished (printing right away would interleave with
+// the output of the console reporter).
+struct throughput_listener : Catch::TestEventListenerBase
+{
+    using TestEventListenerBase::TestEventListenerBase;
+
+    std::vector<std::pair<std::string, double>> results;
+
+    void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override
+    {
+        auto it = benchmark_bytes().find(stats.info.name);
+        if (it != benchmark_bytes().end() && stats.mean.point.count() > 0)
+        {
+            // bytes per nanosecond is GB/s
+            results.emplace_back(stats.info.name,
+                static_cast<double>(it->second) / stats.mean.point.count());
+        }
+    }
+
+    void testCaseEnded(Catch::TestCaseStats const& stats) override
+    {
+        if (!results.empty())
+        {
+            std::cout << "\nThroughput (" << stats.testInfo.name << "):\n";
+            for (auto const& [name, gbps] : results)
+            {
+                std::cout << "  " << std::left << std::setw(40) << name
+                          << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(10) << gbps << " GB/s\n";
+            }
+            std::cout << std::defaultfloat << std::endl;
+            results.clear();
+        }
+        TestEventListenerBase::testCaseEnded(stats);
+    }
+};
+CATCH_REGISTER_LISTENER(throughput_listener)
+
+// Returns a human readable representation of the given size
+std::string size_name(std::size_t size)
+{
+    if (size >= (1u << 30))
+    {
+        return std::to_string(size >> 30) + " GiB";
+    }
+    if (size >= (1u << 20))
+    {
+        return std::to_string(size >> 20) + " MiB";
+    }
+    if (size >= (1u << 10))
+    {
+        return std::to_string(size >> 10) + " KiB";
+    }
+    return std::to_string(size) + " B";
+}
+
+// A buffer whose data starts `offset` bytes after a 64-byte boundary, which
+// allows measuring the kernels on aligned and misaligned data.
+class bench_buffer
+{
+    std::unique_ptr<char[]> storage;
+    std::span<char> data;
+
+public:
+    bench_buffer(std::size_t size, std::size_t offset)
+      : storage(new char[size + 64 + offset])
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        std::size_t skip = (64 - address % 64) % 64 + offset;
+        data = std::span<char>(storage.get() + skip, size);
+    }
+
+    std::span<char> span()
+    {
+        return data;
+    }
+
+    std::span<std::byte> bytes()
+    {
+        return std::as_writable_bytes(data);
+    }
+};
+
+// Fill the given buffer with pseudo random bytes.
+void fill_random(std::span<char> data)
+{
+    unsigned state = 42;
+    for (char& c : data)
+    {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+}
+
+// Register the name of a benchmark along with the number of bytes it
+// processes, and return the name.
+std::string bench_name(std::string const& what, std::size_t size, bool aligned)
+{
+    std::string name = what + (aligned ? " aligned " : " misaligned ") +
+        size_name(size);
+    benchmark_bytes()[name] = size;
+    return name;
+}
+
+std::vector<base64_isa> supported_isas()
+{
+    std::vector<base64_isa> result;
+    for (base64_isa isa : {base64_isa::scalar, base64_isa::ssse3,
+             base64_isa::avx2, base64_isa::avx512})
+    {
+        if (base64_isa_supported(isa))
+        {
+            result.push_back(isa);
+        }
+    }
+    return result;
+}
+
+// Run all encoder benchmarks for an input of the given size.
+void benchmark_encode(std::size_t size)
+{
+    for (bool aligned : {true, false})
+    {
+        std::size_t offset = aligned ? 0 : 1;
+        bench_buffer in(size, offset);
+        bench_buffer out(base64_encoded_size(size), offset);
+        fill_random(in.span());
+
+        for (base64_isa isa : supported_isas())
+        {
+            std::string what = std::string("encode ") + base64_isa_name(isa);
+            BENCHMARK(bench_name(what, size, aligned))
+            {
+                return base64_encode(in.bytes(), out.span(), isa);
+            };
+        }
+
+        BENCHMARK(bench_name("encode streaming", size, aligned))
+        {
+            // feed the encoder 64 KiB at a time
+            base64_encoder encoder;
+            std::span<std::byte const> rest = in.bytes();
+            std::span<char> dest = out.span();
+            while (!rest.empty())
+            {
+                std::size_t chunk = std::min<std::size_t>(rest.size(), 65536);
+                dest = dest.subspan(encoder.update(rest.first(chunk), dest));
+                rest = rest.subspan(chunk);
+            }
+            return encoder.finish(dest);
+        };
+
+        // The string interfaces allocate their result and take their input
+        // as a std::string, whose buffer is aligned either way, so they are
+        // measured once. The span kernels above cover misaligned input.
+        if (aligned)
+        {
+            std::string input(in.span().begin(), in.span().end());
+            BENCHMARK(bench_name("encode string", size, aligned))
+            {
+                return base64_encode(input);
+            };
+            BENCHMARK(bench_name("encode parallel", size, aligned))
+            {
+                return base64_encode_parallel(input);
+            };
+        }
+    }
+}
+
+// Run all decoder benchmarks for an input decoding to the given size.
+void benchmark_decode(std::size_t size)
+{
+    for (bool aligned : {true, false})
+    {
+        std::size_t offset = aligned ? 0 : 1;
+        bench_buffer plain(size, 0);
+        fill_random(plain.span());
+
+        // the decoders need room for the padding bytes, too
+        bench_buffer in(base64_encoded_size(size), offset);
+        bench_buffer out(
+            base64_decoded_size(base64_encoded_size(size)), offset);
+        base64_encode(plain.bytes(), in.span());
+
+        for (base64_isa isa : supported_isas())
+        {
+            if (isa == base64_isa::ssse3)
+            {
+                continue;    // there is no SSSE3 decoder
+            }
+
+            std::string what = std::string("decode ") + base64_isa_name(isa);
+            BENCHMARK(bench_name(what, size, aligned))
+            {
+                return base64_decode(in.span(), out.bytes(), isa);
+            };
+        }
+
+        BENCHMARK(bench_name("decode streaming", size, aligned))
+        {
+            base64_decoder decoder;
+            std::span<char const> rest = in.span();
+            std::span<std::byte> dest = out.bytes();
+            while (!rest.empty())
+            {
+                std::size_t chunk = std::min<std::size_t>(rest.size(), 65536);
+                dest = dest.subspan(decoder.update(rest.first(chunk), dest));
+                rest = rest.subspan(chunk);
+            }
+            decoder.finish();
+            return dest.size();
+        };
+    }
+}
+
+STUDENT_TEST("Benchmark base64 encoding")
+{
+    for (std::size_t size : {16, 256, 4096, 65536, 1 << 20})
+    {
+        benchmark_encode(size);
+    }
+}
+
+STUDENT_TEST("Benchmark base64 decoding")
+{
+    for (std::size_t size : {16, 256, 4096, 65536, 1 << 20})
+    {
+        benchmark_decode(size);
+    }
+}
+
+TEST_CASE("Benchmark base64 encoding of large inputs", "[.][large]")
+{
+    for (std::size_t size : {1 << 24, 1 << 28, 1 << 30})
+    {
+        benchmark_encode(size);
+    }
+}
+
+TEST_CASE("Benchmark base64 decoding of large inputs", "[.][large]")
+{
+    for (std::size_t size : {1 << 24, 1 << 28, 1 << 30})
+    {
+        benchmark_decode(size);
+    }
+}
@@ -0,0 +1,129 @@
+// This file implements the interface declared in aliquot.hpp.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "aliquot.hpp"
+#include "divisor_sums.hpp"
+#include "factorize.hpp"
+#include "thread_count.hpp"
+
+namespace {
+
+    // The number of table entries a thread grabs at once when following
+    // the sequences that leave the table.
+    constexpr std::size_t chunk_size = 1 << 16;
+
+    // Returns s(n) == sigma(n) - n, or 0 if it doesn't fit 64 bits (0 ends
+    // a sequence anyway, s(1) == 0).
+    std::uint64_t aliquot_successor(std::uint64_t n)
+    {
+        unsigned __int128 sum = sigma64(n) - n;
+        return sum > std::numeric_limits<std::uint64_t>::max()
+            ? 0
+            : static_cast<std::uint64_t>(sum);
+    }
+
+    // Replace every clipped entry of the table by the first number below
+    // table.size() the sequence gets back to, within `max_spill` numbers
+    // outside the table. The entries of the sequences that don't return
+    // stay clipped.
+    void contract_excursions(std::vector<std::uint32_t>& table,
+        unsigned max_spill, unsigned num_threads)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = default_thread_count();
+        }
+
+        std::uint64_t const stop = table.size();
+        std::atomic<std::size_t> next_chunk(0);
+        auto worker = [&]() {
+            for (std::size_t lo = next_chunk++ * chunk_size; lo < stop;
+                 lo = next_chunk++ * chunk_size)
+            {
+                std::size_t hi = std::min<std::size_t>(lo + chunk_size, stop);
+                for (std::size_t n = lo; n != hi; ++n)
+                {
+                    if (table[n] != clipped_sum)
+                    {
+                        continue;
+                    }
+                    std::uint64_t m = n;
+                    for (unsigned i = 0; i <= max_spill; ++i)
+                    {
+                        m = aliquot_successor(m);
+                        if (m < stop)
+                        {
+                            table[n] = static_cast<std::uint32_t>(m);
+                            break;
+                        }
+                    }
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            for (unsigned i = 1; i < num_threads; ++i)
+            {
+                threads.emplace_back(worker);
+            }
+            worker();
+        }    // joins all threads
+    }
+}    // namespace
+
+std::vector<std::vector<std::uint64_t>> aliquot_cycles(
+    std::uint64_t stop, unsigned max_spill, unsigned num_threads)
+{
+    std::vector<std::uint32_t> table =
+        clipped_proper_divisor_sums(stop, num_threads);
+    contract_excursions(table, max_spill, num_threads);
+    std::vector<bool> visited(stop, false);
+
+    std::vector<std::vector<std::uint64_t>> cycles;
+    std::vector<std::uint64_t> path;
+    for (std::uint64_t start = 1; start < stop; ++start)
+    {
+        // follow the sequence until it ends, gets lost outside the table or
+        // runs into a number visited before
+        path.clear();
+        std::uint64_t n = start;
+        while (n != 0 && n != clipped_sum && !visited[n])
+        {
+            visited[n] = true;
+            path.push_back(n);
+            n = table[n];
+        }
+
+        // the sequence closed a cycle iff it ran into itself
+        if (n == 0 || n == clipped_sum ||
+            std::find(path.begin(), path.end(), n) == path.end())
+        {
+            continue;
+        }
+
+        // the table skips the members outside of it, follow the cycle
+        // itself from its smallest member to get them back
+        std::uint64_t smallest = *std::min_element(
+            std::find(path.begin(), path.end(), n), path.end());
+        std::vector<std::uint64_t> cycle;
+        std::uint64_t member = smallest;
+        do
+        {
+            cycle.push_back(member);
+            member = aliquot_successor(member);
+        } while (member != smallest);
+        cycles.push_back(std::move(cycle));
+    }
+
+    std::sort(cycles.begin(), cycles.end());
+    return cycles;
+}
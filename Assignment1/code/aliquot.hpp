@@ -0,0 +1,22 @@
+// This file declares the search for aliquot cycles. The aliquot sequence of
+// n repeatedly replaces a number by the sum of its proper divisors, s(n) ==
+// sigma(n) - n. A perfect number is a cycle of length 1, an amicable pair one
+// of length 2 (s(a) == b and s(b) == a), longer ones are called sociable.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Returns the aliquot cycles whose smallest member is less than `stop`, each
+// one starting at its smallest member, ordered by it. The successors of the
+// numbers below `stop` come from a table of clipped_proper_divisor_sums,
+// which limits `stop` to 2^32 - 1. Where a sequence leaves the table it is
+// followed through sigma64 for up to `max_spill` numbers, on up to
+// `num_threads` threads (0 for default_thread_count), and the table entry is
+// replaced by the number the sequence returns to. Then the sequences are
+// followed from every number, marking the numbers as visited, so that each of
+// them is followed once in total. Cycles spending more than `max_spill`
+// consecutive numbers at or above `stop` are missed, amicable pairs need 1.
+std::vector<std::vector<std::uint64_t>> aliquot_cycles(
+    std::uint64_t stop, unsigned max_spill = 4, unsigned num_threads = 0);
@@ -7,11 +7,35 @@ One thing I learned from this part of the assignment is that Euclid's algorithm
 so much more efficient than other traditional ones. 
 
 */
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "catch.hpp"
 
+#include "aliquot.hpp"
+#include "complexity.hpp"
+#include "divisor_summatory.hpp"
+#include "divisor_sums.hpp"
+#include "factorize.hpp"
+#include "mersenne.hpp"
+#include "multiplicative_sieve.hpp"
+#include "prime_sieve.hpp"
+#include "search_channel.hpp"
+#include "sigma_table.hpp"
+
 using namespace std;
 
 
@@ -50,22 +74,19 @@ int find_perfects_numbers_faster(long stop)
 }
 
 
-long find_nth_perfect_euclid(long n) {
-    long perfect = 0;
-    long num_perfects = 0;
-    long m = 0;
-    bool isPrime = false;
-    int k = 1;
-    while(num_perfects != n) {
-        m = (1 << k) - 1; // bit left shit = 2^k - 1
-        isPrime = m != 1 && faster_sum(m) == 1; // 1 is not prime
-        if (isPrime) {
-            num_perfects++;
-            perfect = (1 << (k - 1)) * m;
-        }
-        k++;
+// The find_nth_perfect_euclid function returns the nth perfect number using
+// Euclid's observation that 2^(k-1) * (2^k - 1) is perfect whenever 2^k - 1
+// is prime, which is decided by the Lucas-Lehmer test. Only the first 8
+// perfect numbers fit into a long, nth_perfect_number returns any of them as
+// a string.
+long find_nth_perfect_euclid(long n)
+{
+    if (n < 1 || n > 8)
+    {
+        throw std::runtime_error(
+            "find_nth_perfect_euclid: the perfect number does not fit a long");
     }
-    return perfect;
+    return std::stol(nth_perfect_number(static_cast<unsigned>(n)));
 }
 
 
@@ -90,10 +111,11 @@ long divisor_sum(long n)
 // The is_perfect function takes one argument `n` and returns a boolean
 // (true/false) value indicating whether or not `n` is perfect. A perfect number
 // is a non-zero positive number whose sum of its proper divisors is equal to
-// itself.
+// itself. Instead of trying every possible divisor it factors `n` and computes
+// the sum of all divisors (2n for a perfect number) from the factorization.
 bool is_perfect(long n)
 {
-    return n != 0 && n == divisor_sum(n);
+    return n > 0 && sigma64(n) == 2 * static_cast<unsigned __int128>(n);
 }
 
 // The findPerfects function takes one argument `stop` and performs an
@@ -112,6 +134,32 @@ int find_perfect_numbers(long stop)
     return found;
 }
 
+// The find_perfect_numbers_sieve function counts the perfect numbers in the
+// range 1 to `stop` like find_perfect_numbers, but computes the divisor sums
+// of the whole range in one pass of a sieve first. Checking a number is then
+// a single table lookup.
+int find_perfect_numbers_sieve(long stop)
+{
+    if (stop < 1)
+    {
+        return 0;
+    }
+    std::vector<std::uint64_t> sums = proper_divisor_sums(stop);
+    return static_cast<int>(count_number_kinds(sums).perfect);
+}
+
+// The find_perfect_numbers_segmented function counts the perfect numbers in
+// the range 1 to `stop` like find_perfect_numbers_sieve, but sieves the range
+// block by block on all cores, using a fixed amount of memory.
+int find_perfect_numbers_segmented(long stop)
+{
+    if (stop < 1)
+    {
+        return 0;
+    }
+    return static_cast<int>(search_perfect_numbers(1, stop).counts.perfect);
+}
+
 // Test cases
 PROVIDED_TEST("count perfect numbers")
 {
@@ -197,4 +245,836 @@ STUDENT_TEST("Testing n'th perfect Euclid")
     CHECK(is_perfect(find_nth_perfect_euclid(3)));
     CHECK(is_perfect(find_nth_perfect_euclid(4)));
     CHECK(is_perfect(find_nth_perfect_euclid(5)));
+
+    CHECK(find_nth_perfect_euclid(8) == 2305843008139952128);
+    CHECK_THROWS(find_nth_perfect_euclid(0));
+    CHECK_THROWS(find_nth_perfect_euclid(9));
+}
+
+STUDENT_TEST("Lucas-Lehmer test for Mersenne primes")
+{
+    CHECK(!is_mersenne_prime(0));
+    CHECK(!is_mersenne_prime(1));
+    CHECK(is_mersenne_prime(2));
+    CHECK(is_mersenne_prime(3));
+    CHECK(!is_mersenne_prime(4));
+    CHECK(!is_mersenne_prime(11));    // 2047 == 23 * 89
+    CHECK(is_mersenne_prime(127));
+    CHECK(!is_mersenne_prime(131));
+
+    // squared with the FFT
+    CHECK(is_mersenne_prime(9689));
+    CHECK(!is_mersenne_prime(9697));
+
+    std::vector<unsigned> expected = {2, 3, 5, 7, 13, 17, 19, 31, 61, 89, 107,
+        127, 521, 607, 1279, 2203, 2281, 3217, 4253, 4423};
+    CHECK(mersenne_prime_exponents(20, 1) == expected);
+    CHECK(mersenne_prime_exponents(20, 3) == expected);
+    CHECK(mersenne_prime_exponents(0).empty());
+}
+
+STUDENT_TEST("Trial factoring of Mersenne numbers")
+{
+    CHECK(mersenne_factor(11) == 23);
+    CHECK(mersenne_factor(23) == 47);
+    CHECK(mersenne_factor(29) == 233);    // 233 * 1103 * 2089
+    CHECK(mersenne_factor(37) == 223);
+
+    // no factor for primes, exponents that are not odd primes are skipped
+    CHECK(mersenne_factor(2) == 0);
+    CHECK(mersenne_factor(31) == 0);
+    CHECK(mersenne_factor(4423) == 0);
+    CHECK(mersenne_factor(9) == 0);
+
+    CHECK(mersenne_factor(10007) == 240169);
+    CHECK(mersenne_factor(9697) == 0);    // composite, left to Lucas-Lehmer
+}
+
+STUDENT_TEST("Perfect numbers beyond the range of long")
+{
+    CHECK(nth_perfect_number(1) == "6");
+    CHECK(nth_perfect_number(8) == "2305843008139952128");
+    CHECK(nth_perfect_number(9) == "2658455991569831744654692615953842176");
+    CHECK(nth_perfect_number(12, 16) ==
+        "1fffffffffffffffffffffffffffffffc0000000000000000000000000000000");
+
+    CHECK(perfect_number_string(3, 16) == "1c");
+    CHECK(perfect_number_string(4423).size() == 2663);
+
+    // the formatting of the 25th perfect number, finding it is left to the
+    // [large] test below
+    std::string perfect = perfect_number_string(21701);
+    CHECK(perfect.size() == 13066);
+    CHECK(perfect.substr(0, 20) == "10065649705464004218");
+    CHECK(perfect.substr(13046) == "87858865255141605376");
+
+    CHECK_THROWS(perfect_number_string(5, 8));
+    CHECK_THROWS(nth_perfect_number(0));
+}
+
+// Runs the Lucas-Lehmer tests up to the 25th Mersenne prime, which takes
+// about 3 minutes on a single core, so only when asked for with
+// `benchmark [large]`.
+TEST_CASE("The 25th Mersenne prime", "[student][.][large]")
+{
+    CHECK(mersenne_prime_exponents(25).back() == 21701);
+}
+
+STUDENT_TEST("Single BENCHMARK of the Lucas-Lehmer test")
+{
+    BENCHMARK("Find the 15th perfect number")
+    {
+        return nth_perfect_number(15, 10, 1);
+    };
+    BENCHMARK("Lucas-Lehmer test of 2^4423 - 1")
+    {
+        return is_mersenne_prime(4423);
+    };
+}
+
+STUDENT_TEST("Sieve divisor sums match divisor_sum()")
+{
+    std::vector<std::uint64_t> sums = proper_divisor_sums(5000);
+    REQUIRE(sums.size() == 5000);
+    CHECK(sums[0] == 0);
+    for (long n = 1; n < 5000; ++n)
+    {
+        CHECK(static_cast<long>(sums[n]) == divisor_sum(n));
+    }
+
+    CHECK(proper_divisor_sums(0).empty());
+    CHECK(proper_divisor_sums(1) == std::vector<std::uint64_t>{0});
+    CHECK(proper_divisor_sums(2) == std::vector<std::uint64_t>{0, 0});
+}
+
+STUDENT_TEST("Sieve classifies numbers like divisor_sum()")
+{
+    std::vector<std::uint64_t> sums = proper_divisor_sums(10000);
+    number_kind_counts expected;
+    for (long n = 1; n < 10000; ++n)
+    {
+        long sum = divisor_sum(n);
+        if (sum < n)
+        {
+            ++expected.deficient;
+        }
+        else if (sum == n)
+        {
+            ++expected.perfect;
+        }
+        else
+        {
+            ++expected.abundant;
+        }
+    }
+
+    number_kind_counts counts = count_number_kinds(sums);
+    CHECK(counts.deficient == expected.deficient);
+    CHECK(counts.perfect == expected.perfect);
+    CHECK(counts.abundant == expected.abundant);
+    CHECK(counts.abundant == 2487);    // OEIS A005101
+
+    CHECK(classify(6, sums[6]) == number_kind::perfect);
+    CHECK(classify(12, sums[12]) == number_kind::abundant);
+    CHECK(classify(1, sums[1]) == number_kind::deficient);
+}
+
+STUDENT_TEST("Testing sieve perfect number search")
+{
+    CHECK(find_perfect_numbers_sieve(0) == 0);
+    CHECK(find_perfect_numbers_sieve(10) == 1);
+    CHECK(find_perfect_numbers_sieve(100) == 2);
+    CHECK(find_perfect_numbers_sieve(10000) == 4);
+    CHECK(find_perfect_numbers_sieve(40000) == 4);
+
+    CHECK(perfect_numbers_below(33550337) ==
+        std::vector<std::uint64_t>{6, 28, 496, 8128, 33550336});
+}
+
+STUDENT_TEST("Single BENCHMARK of find_perfect_numbers_sieve()")
+{
+    int sizes[3] = {10000, 80000, 1000000};
+
+    for (int i = 0; i < 3; i++)
+    {
+        BENCHMARK("Sieve perfect numbers up to " + std::to_string(sizes[i]))
+        {
+            return find_perfect_numbers_sieve(sizes[i]);
+        };
+    }
+}
+
+STUDENT_TEST("Segmented search matches the sieve")
+{
+    std::vector<std::uint64_t> sums = proper_divisor_sums(300000);
+    for (unsigned threads : {1u, 2u, 3u, 8u})
+    {
+        // ranges starting and ending inside and on the edges of blocks
+        for (auto [lo, hi] : {std::pair<std::uint64_t, std::uint64_t>{0, 1},
+                 {1, 2}, {0, 300000}, {5, 32768}, {32767, 32769},
+                 {100000, 300000}, {12345, 234567}})
+        {
+            perfect_search_result found =
+                search_perfect_numbers(lo, hi, threads);
+
+            number_kind_counts expected;
+            std::vector<std::uint64_t> perfect;
+            for (std::uint64_t n = std::max<std::uint64_t>(lo, 1); n < hi; ++n)
+            {
+                if (sums[n] < n)
+                {
+                    ++expected.deficient;
+                }
+                else if (sums[n] == n)
+                {
+                    ++expected.perfect;
+                    perfect.push_back(n);
+                }
+                else
+                {
+                    ++expected.abundant;
+                }
+            }
+
+            CHECK(found.counts.deficient == expected.deficient);
+            CHECK(found.counts.perfect == expected.perfect);
+            CHECK(found.counts.abundant == expected.abundant);
+            CHECK(found.perfect_numbers == perfect);
+        }
+    }
+
+    CHECK(search_perfect_numbers(10, 10).counts.deficient == 0);
+    CHECK(search_perfect_numbers(10, 5).perfect_numbers.empty());
+}
+
+STUDENT_TEST("Segmented search finds large perfect numbers")
+{
+    CHECK(find_perfect_numbers_segmented(10000) == 4);
+    CHECK(search_perfect_numbers(1, 33550337, 4).perfect_numbers ==
+        std::vector<std::uint64_t>{6, 28, 496, 8128, 33550336});
+
+    // the 6th and 7th perfect numbers, far beyond what a flat table holds
+    CHECK(search_perfect_numbers(8589800000, 8589900000).perfect_numbers ==
+        std::vector<std::uint64_t>{8589869056});
+    CHECK(search_perfect_numbers(137438600000, 137438700000)
+              .perfect_numbers == std::vector<std::uint64_t>{137438691328});
+}
+
+STUDENT_TEST("Single BENCHMARK of find_perfect_numbers_segmented()")
+{
+    int sizes[3] = {10000, 80000, 1000000};
+
+    for (int i = 0; i < 3; i++)
+    {
+        BENCHMARK("Segmented perfect numbers up to " + std::to_string(sizes[i]))
+        {
+            return find_perfect_numbers_segmented(sizes[i]);
+        };
+    }
+}
+
+STUDENT_TEST("sigma64 matches divisor_sum()")
+{
+    for (long n = 1; n < 5000; ++n)
+    {
+        CHECK(sigma64(n) - n == static_cast<unsigned __int128>(divisor_sum(n)));
+    }
+    CHECK(sigma64(0) == 0);
+    CHECK(sigma64(1) == 1);
+}
+
+STUDENT_TEST("Factoring 64-bit numbers")
+{
+    CHECK(is_prime64(2));
+    CHECK(!is_prime64(1));
+    CHECK(!is_prime64(3215031751));    // fools the bases 2, 3, 5 and 7
+    CHECK(is_prime64(2305843009213693951));    // 2^61 - 1
+    CHECK(is_prime64(18446744073709551557u));    // the largest 64-bit prime
+    CHECK(!is_prime64(18446744073709551615u));
+
+    std::vector<prime_power> factors = factorize(4611685975477714963);
+    REQUIRE(factors.size() == 2);    // (2^31 - 1) * (2^31 - 19)
+    CHECK(factors[0].prime == 2147483629);
+    CHECK(factors[1].prime == 2147483647);
+    CHECK(factorize(1).empty());
+    CHECK(factorize(1024).size() == 1);
+    CHECK(factorize(1024)[0].exponent == 10);
+
+    // the sum of divisors does not always fit 64 bits
+    CHECK(sigma64(3590449939146470400) >
+        static_cast<unsigned __int128>(UINT64_MAX));
+}
+
+STUDENT_TEST("is_perfect() on large numbers")
+{
+    CHECK(is_perfect(8589869056));
+    CHECK(is_perfect(137438691328));
+    CHECK(is_perfect(2305843008139952128));
+    CHECK(!is_perfect(2305843008139952127));
+    CHECK(!is_perfect(999999999999999989));
+}
+
+STUDENT_TEST("Single BENCHMARK of is_perfect()")
+{
+    BENCHMARK("is_perfect() of 1000 numbers from 10^18")
+    {
+        int found = 0;
+        for (long n = 1000000000000000000; n != 1000000000000001000; ++n)
+        {
+            found += is_perfect(n);
+        }
+        return found;
+    };
+}
+
+STUDENT_TEST("Batched divisor sums match divisor_sum()")
+{
+    std::vector<std::int64_t> numbers;
+    for (long n = 5000; n >= -5; --n)
+    {
+        numbers.push_back(n);
+    }
+    std::vector<std::uint64_t> sums = divisor_sums(numbers);
+    REQUIRE(sums.size() == numbers.size());
+    for (std::size_t i = 0; i != numbers.size(); ++i)
+    {
+        long expected = numbers[i] < 1 ? 0 : divisor_sum(numbers[i]);
+        CHECK(static_cast<long>(sums[i]) == expected);
+    }
+
+    // around the square of the largest divisor tested and the 32-bit limit,
+    // above which sigma64 takes over
+    numbers = {4294836225, 4294967291, 4294967295, 4294967296, 8589869056};
+    sums = divisor_sums(numbers);
+    for (std::size_t i = 0; i != numbers.size(); ++i)
+    {
+        CHECK(sums[i] == sigma64(numbers[i]) - numbers[i]);
+    }
+    CHECK(divisor_sums({}).empty());
+}
+
+STUDENT_TEST("Single BENCHMARK of divisor_sums()")
+{
+    std::vector<std::int64_t> numbers;
+    for (std::int64_t i = 1; i <= 1000; ++i)
+    {
+        numbers.push_back(i * 2654435761 % 1000000000);
+    }
+
+    BENCHMARK("faster_sum() of 1000 numbers below 10^9")
+    {
+        long total = 0;
+        for (std::int64_t n : numbers)
+        {
+            total += faster_sum(n);
+        }
+        return total;
+    };
+    BENCHMARK("divisor_sums() of 1000 numbers below 10^9")
+    {
+        return divisor_sums(numbers);
+    };
+}
+
+STUDENT_TEST("Multiplicative sieve of sigma, phi, mu and d")
+{
+    multiplicative_sieve<sigma_rule, phi_rule, mu_rule, divisor_count_rule>
+        sieve(10000);
+    std::vector<std::uint64_t> const& sigma = sieve.table<sigma_rule>();
+    std::vector<std::uint32_t> const& phi = sieve.table<phi_rule>();
+    std::vector<std::int8_t> const& mu = sieve.table<mu_rule>();
+    std::vector<std::uint16_t> const& d = sieve.table<divisor_count_rule>();
+    REQUIRE(sigma.size() == 10000);
+    REQUIRE(mu.size() == 10000);
+
+    long mertens = 0;
+    std::uint64_t phi_sum = 0;
+    for (long n = 1; n < 10000; ++n)
+    {
+        CHECK(static_cast<long>(sigma[n]) - n == divisor_sum(n));
+        mertens += mu[n];
+        if (n <= 100)
+        {
+            phi_sum += phi[n];
+        }
+    }
+    CHECK(mertens == -23);
+    CHECK(phi_sum == 3044);
+
+    CHECK(phi[1] == 1);
+    CHECK(phi[9973] == 9972);    // a prime
+    CHECK(phi[1024] == 512);
+    CHECK(phi[9240] == 1920);    // 2^3 * 3 * 5 * 7 * 11
+    CHECK(mu[1] == 1);
+    CHECK(mu[30] == -1);
+    CHECK(mu[210] == 1);
+    CHECK(mu[12] == 0);
+    CHECK(d[1] == 1);
+    CHECK(d[9240] == 64);
+    CHECK(d[7560] == 64);    // 2^3 * 3^3 * 5 * 7
+    CHECK(sigma[0] == 0);
+
+    CHECK(multiplicative_sieve<mu_rule>(0).table<mu_rule>().empty());
+    CHECK(multiplicative_sieve<mu_rule>(2).table<mu_rule>()[1] == 1);
+    CHECK_THROWS(multiplicative_sieve<mu_rule>(std::uint64_t(1) << 33));
+}
+
+STUDENT_TEST("Single BENCHMARK of the multiplicative sieve")
+{
+    BENCHMARK("sigma up to 1000000")
+    {
+        return multiplicative_sieve<sigma_rule>(1000000)
+            .table<sigma_rule>()
+            .back();
+    };
+    BENCHMARK("sigma, phi, mu and d up to 1000000 in one pass")
+    {
+        return multiplicative_sieve<sigma_rule, phi_rule, mu_rule,
+            divisor_count_rule>(1000000)
+            .table<divisor_count_rule>()
+            .back();
+    };
+}
+
+STUDENT_TEST("Clipped divisor sums match the sieve")
+{
+    std::vector<std::uint64_t> sums = proper_divisor_sums(100000);
+    std::vector<std::uint32_t> clipped = clipped_proper_divisor_sums(100000, 3);
+    REQUIRE(clipped.size() == sums.size());
+    for (std::size_t n = 0; n != sums.size(); ++n)
+    {
+        CHECK(clipped[n] == (sums[n] < 100000 ? sums[n] : clipped_sum));
+    }
+    CHECK(clipped_proper_divisor_sums(1).size() == 1);
+    CHECK_THROWS(clipped_proper_divisor_sums(std::uint64_t(1) << 32));
+}
+
+STUDENT_TEST("Aliquot cycles")
+{
+    using cycle = std::vector<std::uint64_t>;
+    std::vector<cycle> cycles = aliquot_cycles(20000, 32);
+    std::vector<cycle> expected = {{6}, {28}, {220, 284}, {496}, {1184, 1210},
+        {2620, 2924}, {5020, 5564}, {6232, 6368}, {8128}, {10744, 10856},
+        {12285, 14595}, {12496, 14288, 15472, 14536, 14264},
+        {14316, 19116, 31704, 47616, 83328, 177792, 295488, 629072, 589786,
+            294896, 358336, 418904, 366556, 274924, 275444, 243760, 376736,
+            381028, 285778, 152990, 122410, 97946, 48976, 45946, 22976, 22744,
+            19916, 17716},
+        {17296, 18416}};
+    CHECK(cycles == expected);
+
+    // the cycle of 14316 spends 26 numbers in a row above 20000
+    expected.erase(expected.begin() + 12);
+    CHECK(aliquot_cycles(20000) == expected);
+
+    // the pair is found from 220 alone
+    CHECK(aliquot_cycles(221) == std::vector<cycle>{{6}, {28}, {220, 284}});
+    CHECK(aliquot_cycles(0).empty());
+
+    std::size_t amicable_pairs = 0;
+    for (cycle const& c : aliquot_cycles(1000000))
+    {
+        amicable_pairs += c.size() == 2;
+    }
+    CHECK(amicable_pairs == 42);
+}
+
+STUDENT_TEST("Single BENCHMARK of aliquot_cycles()")
+{
+    BENCHMARK("Aliquot cycles below 1000000")
+    {
+        return aliquot_cycles(1000000).size();
+    };
+}
+
+STUDENT_TEST("Persistent sigma table")
+{
+    std::string path =
+        (std::filesystem::temp_directory_path() / "sigma_table_test.bin")
+            .string();
+    std::filesystem::remove(path);
+
+    std::vector<std::uint64_t> sums = proper_divisor_sums(50000);
+    {
+        sigma_table table(path, 10000, 3);
+        REQUIRE(table.size() == 10000);
+        for (std::uint64_t n = 0; n != 10000; ++n)
+        {
+            CHECK(table.proper_divisor_sum(n) == sums[n]);
+        }
+        CHECK(table.kind(8128) == number_kind::perfect);
+        CHECK(table.verify());
+    }
+
+    // a smaller range is served from the file as it is, a larger one is
+    // appended
+    CHECK(sigma_table(path, 5000).size() == 10000);
+    CHECK(std::filesystem::file_size(path) == 64 + 8 * 10000);
+    {
+        sigma_table table(path, 50000);
+        REQUIRE(table.size() == 50000);
+        for (std::uint64_t n = 1; n != 50000; ++n)
+        {
+            CHECK(table.proper_divisor_sum(n) == sums[n]);
+        }
+        CHECK(table.verify());
+    }
+
+    // damage an entry
+    {
+        std::fstream file(
+            path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 8 * 12345);
+        file.put('x');
+    }
+    CHECK(!sigma_table(path).verify());
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a sigma table, but long enough to have a header......";
+    }
+    CHECK_THROWS_AS(sigma_table(path), std::runtime_error);
+    std::filesystem::remove(path);
+    CHECK_THROWS_AS(sigma_table(path), std::system_error);
+
+    // a creation interrupted before the header was written starts over
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(64 + 8 * 100, '\0');
+    }
+    CHECK(sigma_table(path, 1000).verify());
+
+    // two extensions at the same time take turns
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i != 2; ++i)
+        {
+            threads.emplace_back([&] { sigma_table(path, 50000, 1); });
+        }
+    }
+    {
+        sigma_table table(path);
+        CHECK(table.size() == 50000);
+        CHECK(table.proper_divisor_sum(49999) == sums[49999]);
+        CHECK(table.verify());
+    }
+    std::filesystem::remove(path);
+}
+
+STUDENT_TEST("Single BENCHMARK of the persistent sigma table")
+{
+    std::string path =
+        (std::filesystem::temp_directory_path() / "sigma_table_bench.bin")
+            .string();
+    std::filesystem::remove(path);
+    sigma_table(path, 1000000);
+
+    BENCHMARK("Sieve sigma up to 1000000")
+    {
+        return proper_divisor_sums(1000000).back();
+    };
+    BENCHMARK("Map the stored table up to 1000000")
+    {
+        return sigma_table(path, 1000000).sigma(999999);
+    };
+    std::filesystem::remove(path);
+}
+
+STUDENT_TEST("Summatory divisor functions")
+{
+    multiplicative_sieve<sigma_rule, divisor_count_rule> sieve(20000);
+    std::vector<std::uint64_t> const& sigma = sieve.table<sigma_rule>();
+    std::vector<std::uint16_t> const& d = sieve.table<divisor_count_rule>();
+    std::uint64_t sigma_sum = 0;
+    std::uint64_t d_sum = 0;
+    for (std::uint64_t n = 0; n != 20000; ++n)
+    {
+        sigma_sum += sigma[n];
+        d_sum += d[n];
+        CHECK(sigma_summatory(n) == sigma_sum);
+        CHECK(divisor_count_summatory(n) == d_sum);
+    }
+
+    CHECK(divisor_count_summatory(1000000) == 13970034);
+    CHECK(sigma_summatory(1000000) == 822468118437);
+    CHECK(divisor_count_summatory(1000000000000) == 27785452449086);
+    CHECK(sigma_summatory(1000000000000) ==
+        822467033425 * static_cast<unsigned __int128>(1000000000000) +
+            357340138978);
+}
+
+STUDENT_TEST("Single BENCHMARK of the summatory divisor functions")
+{
+    BENCHMARK("Sum of sigma up to 10000 with faster_sum()")
+    {
+        long total = 0;
+        for (long n = 1; n <= 10000; ++n)
+        {
+            total += faster_sum(n) + (n > 1 ? n : 0);
+        }
+        return total;
+    };
+    BENCHMARK("Sum of sigma up to 10000 with the sieve")
+    {
+        std::vector<std::uint64_t> sums = proper_divisor_sums(10001);
+        std::uint64_t total = 0;
+        for (std::uint64_t n = 1; n <= 10000; ++n)
+        {
+            total += sums[n] + n;
+        }
+        return total;
+    };
+    BENCHMARK("Sum of sigma up to 10000 by the hyperbola method")
+    {
+        return static_cast<std::uint64_t>(sigma_summatory(10000));
+    };
+    BENCHMARK("Sum of sigma up to 10^12 by the hyperbola method")
+    {
+        return static_cast<std::uint64_t>(sigma_summatory(1000000000000));
+    };
+    BENCHMARK("Sum of d up to 10^12 by the hyperbola method")
+    {
+        return static_cast<std::uint64_t>(
+            divisor_count_summatory(1000000000000));
+    };
+}
+
+STUDENT_TEST("Wheel prime sieve")
+{
+    std::vector<std::uint64_t> primes = primes_in(0, 100000);
+    REQUIRE(primes.size() == 9592);
+    std::size_t next = 0;
+    for (std::uint64_t n = 0; n != 100000; ++n)
+    {
+        bool prime = n > 1 && faster_sum(n) == 1;
+        CHECK(is_prime(n) == prime);
+        if (prime)
+        {
+            CHECK(primes[next++] == n);
+        }
+    }
+
+    // ranges starting and ending within a byte and across segments
+    for (std::uint64_t lo : {std::uint64_t(0), std::uint64_t(983040 - 17),
+             std::uint64_t(1000000000000), std::uint64_t(1) << 40})
+    {
+        std::uint64_t hi = lo + 2000003;
+        std::vector<std::uint64_t> expected;
+        for (std::uint64_t n = lo; n != hi; ++n)
+        {
+            if (is_prime64(n))
+            {
+                expected.push_back(n);
+            }
+        }
+        CHECK(primes_in(lo, hi) == expected);
+    }
+    CHECK(primes_in(2, 3) == std::vector<std::uint64_t>{2});
+    CHECK(primes_in(7, 8) == std::vector<std::uint64_t>{7});
+    CHECK(primes_in(31, 32) == std::vector<std::uint64_t>{31});
+    CHECK(primes_in(30, 31).empty());
+    CHECK(primes_in(100, 10).empty());
+
+    CHECK(prime_pi(0) == 0);
+    CHECK(prime_pi(1) == 0);
+    CHECK(prime_pi(2) == 1);
+    CHECK(prime_pi(5) == 3);
+    CHECK(prime_pi(1000000) == 78498);
+    CHECK(prime_pi(100000000) == 5761455);
+    CHECK(is_prime(1048573));    // the largest prime below 2^20
+    CHECK(is_prime(1048583));    // the smallest one above it
+    CHECK(!is_prime(1048575));
+}
+
+STUDENT_TEST("Single BENCHMARK of the wheel prime sieve")
+{
+    BENCHMARK("Count the primes up to 10^7 with a plain sieve")
+    {
+        std::vector<bool> composite(10000001, false);
+        std::uint64_t count = 0;
+        for (std::uint64_t n = 2; n <= 10000000; ++n)
+        {
+            if (!composite[n])
+            {
+                ++count;
+                for (std::uint64_t m = n * n; m <= 10000000; m += n)
+                {
+                    composite[m] = true;
+                }
+            }
+        }
+        return count;
+    };
+    BENCHMARK("Count the primes up to 10^7 with the wheel sieve")
+    {
+        return prime_pi(10000000);
+    };
+}
+
+STUDENT_TEST("Search channel")
+{
+    search_channel channel;
+    for (std::uint64_t n = 0; n != search_channel::capacity; ++n)
+    {
+        CHECK(channel.try_push(n));
+    }
+    CHECK(!channel.try_push(64));
+    for (std::uint64_t n = 0; n != 10; ++n)
+    {
+        CHECK(channel.try_pop() == n);
+    }
+    CHECK(channel.try_push(64));
+    for (std::uint64_t n = 10; n != 65; ++n)
+    {
+        CHECK(channel.try_pop() == n);
+    }
+    CHECK(!channel.try_pop());
+
+    // a consumer on another thread receives every number in order
+    std::uint64_t const count = 100000;
+    std::uint64_t received = 0;
+    bool in_order = true;
+    {
+        std::jthread consumer([&] {
+            while (received != count)
+            {
+                if (auto n = channel.try_pop())
+                {
+                    in_order = in_order && *n == received;
+                    ++received;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (std::uint64_t n = 0; n != count; ++n)
+        {
+            while (!channel.try_push(n))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+    CHECK(received == count);
+    CHECK(in_order);
+}
+
+STUDENT_TEST("Cancellable perfect number search")
+{
+    search_channel channel;
+    perfect_search_result result =
+        search_perfect_numbers(1, 10000000, {}, channel, 3);
+    CHECK(result.perfect_numbers ==
+        std::vector<std::uint64_t>{6, 28, 496, 8128});
+    CHECK(channel.searched() == 9999999);
+    CHECK(channel.counts().abundant == result.counts.abundant);
+    for (std::uint64_t n : result.perfect_numbers)
+    {
+        CHECK(channel.try_pop() == n);
+    }
+    CHECK(!channel.try_pop());
+
+    std::stop_source cancel;
+    cancel.request_stop();
+    search_channel unused;
+    result = search_perfect_numbers(1, 10000000, cancel.get_token(), unused);
+    CHECK(unused.searched() == 0);
+    CHECK(result.counts.deficient == 0);
+
+    // stop as soon as the first numbers come in
+    std::stop_source early;
+    search_channel watched;
+    {
+        std::jthread watcher([&] {
+            while (watched.searched() == 0)
+            {
+                std::this_thread::yield();
+            }
+            early.request_stop();
+        });
+        result = search_perfect_numbers(
+            1, 1000000000, early.get_token(), watched, 2);
+    }
+    std::uint64_t searched = result.counts.deficient + result.counts.perfect +
+        result.counts.abundant;
+    CHECK(searched == watched.searched());
+    CHECK(searched > 0);
+    CHECK(searched < 999999999);
+}
+
+STUDENT_TEST("Single BENCHMARK of the cancellable search")
+{
+    BENCHMARK("Search up to 10^7")
+    {
+        return search_perfect_numbers(1, 10000000).counts.abundant;
+    };
+    BENCHMARK("Search up to 10^7 reporting to a channel")
+    {
+        search_channel channel;
+        return search_perfect_numbers(1, 10000000, {}, channel)
+            .counts.abundant;
+    };
+}
+
+STUDENT_TEST("Fitting complexity models")
+{
+    std::vector<timing_sample> power;
+    std::vector<timing_sample> linearithmic;
+    for (std::uint64_t n = 1000; n <= 64000; n *= 2)
+    {
+        double t = 2e-9 * std::pow(double(n), 1.5);
+        power.push_back({n, t, t, t});
+        t = 3e-8 * double(n) * std::log(double(n));
+        linearithmic.push_back({n, t, t, t});
+    }
+
+    complexity_report report = fit_complexity(power);
+    CHECK(report.fits.front().name == "n^1.5");
+    CHECK(report.fits.front().error == Approx(0).margin(1e-12));
+    CHECK(report.exponent == Approx(1.5));
+    CHECK(report.extrapolate(1000000) == Approx(2));
+
+    report = fit_complexity(linearithmic);
+    CHECK(report.fits.front().name == "n log n");
+    CHECK(report.exponent > 1);
+    CHECK(report.exponent < 1.2);
+
+    std::ostringstream csv;
+    write_csv(csv, report);
+    std::string const text = csv.str();
+    CHECK(text.substr(0, text.find('\n')) ==
+        "size,mean,ci_low,ci_high,n,n log n,n^1.5,n^2");
+    CHECK(std::count(text.begin(), text.end(), '\n') == 8);
+
+    CHECK_THROWS(fit_complexity({power.front()}));
+    CHECK_THROWS(measure_complexity([](std::uint64_t) {}, 10, 15));
+}
+
+// Measure how find_perfects_numbers_faster() scales and extrapolate to the
+// fifth perfect number, 33550336, the timings are written to a CSV file.
+// The measured exponent depends on the load of the machine, so this only
+// runs when asked for with `benchmark [scaling]`.
+TEST_CASE("Scaling of find_perfects_numbers_faster()", "[student][.scaling]")
+{
+    int found = 0;
+    complexity_report report = measure_complexity(
+        [&](std::uint64_t n) {
+            found = find_perfects_numbers_faster(static_cast<long>(n));
+        },
+        2500, 80000);
+    CHECK(found == 4);
+    print_summary(std::cout, report);
+    std::cout << "Predicted time up to 33550336: " << std::fixed
+              << std::setprecision(1) << report.extrapolate(33550336) / 60
+              << " minutes\n"
+              << std::defaultfloat;
+
+    std::ofstream csv("find_perfects_numbers_faster.csv");
+    write_csv(csv, report);
+
+    // the divisors are tried up to sqrt(n) for each n
+    CHECK(report.exponent > 1.3);
+    CHECK(report.exponent < 1.7);
 }
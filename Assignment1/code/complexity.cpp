@@ -0,0 +1,231 @@
+// This file implements the interface declared in complexity.hpp.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "complexity.hpp"
+
+namespace {
+
+    // The candidate models, n log n with the natural logarithm.
+    struct model
+    {
+        char const* name;
+        double (*growth)(double n);
+    };
+
+    model const models[] = {
+        {"n", [](double n) { return n; }},
+        {"n log n", [](double n) { return n * std::log(n); }},
+        {"n^1.5", [](double n) { return n * std::sqrt(n); }},
+        {"n^2", [](double n) { return n * n; }},
+    };
+
+    // The 97.5% quantiles of Student's t distribution with 1 to 30 degrees
+    // of freedom, beyond that the normal distribution's 1.96 is close
+    // enough.
+    constexpr double t_quantiles[] = {12.706, 4.303, 3.182, 2.776, 2.571,
+        2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+        2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060,
+        2.056, 2.052, 2.048, 2.045, 2.042};
+
+    double t_quantile(std::size_t degrees_of_freedom)
+    {
+        constexpr std::size_t tabulated = std::size(t_quantiles);
+        return degrees_of_freedom <= tabulated
+            ? t_quantiles[degrees_of_freedom - 1]
+            : 1.96;
+    }
+
+    // Summarize the repeated timings of one size.
+    timing_sample summarize(
+        std::uint64_t size, std::vector<double> const& times)
+    {
+        double const count = static_cast<double>(times.size());
+        double sum = 0;
+        for (double t : times)
+        {
+            sum += t;
+        }
+        double const mean = sum / count;
+        double squares = 0;
+        for (double t : times)
+        {
+            squares += (t - mean) * (t - mean);
+        }
+        double const deviation = std::sqrt(squares / (count - 1));
+        double const half_width =
+            t_quantile(times.size() - 1) * deviation / std::sqrt(count);
+        return {size, mean, std::max(mean - half_width, 0.0),
+            mean + half_width};
+    }
+
+    // Fit t == c * growth(n) minimizing the sum of (1 - c * growth(n) / t)^2,
+    // which is solved by c == sum(g / t) / sum((g / t)^2).
+    model_fit fit(model const& m, std::vector<timing_sample> const& samples)
+    {
+        double linear = 0;
+        double quadratic = 0;
+        for (timing_sample const& s : samples)
+        {
+            double const ratio = m.growth(double(s.size)) / s.mean;
+            linear += ratio;
+            quadratic += ratio * ratio;
+        }
+        double const coefficient = linear / quadratic;
+
+        double squares = 0;
+        for (timing_sample const& s : samples)
+        {
+            double const relative =
+                1 - coefficient * m.growth(double(s.size)) / s.mean;
+            squares += relative * relative;
+        }
+        return {m.name, m.growth, coefficient,
+            std::sqrt(squares / double(samples.size()))};
+    }
+
+    // Returns the slope of the line fitted to (log n, log t).
+    double power_law_exponent(std::vector<timing_sample> const& samples)
+    {
+        double const count = static_cast<double>(samples.size());
+        double sum_x = 0;
+        double sum_y = 0;
+        for (timing_sample const& s : samples)
+        {
+            sum_x += std::log(double(s.size));
+            sum_y += std::log(s.mean);
+        }
+        double covariance = 0;
+        double variance = 0;
+        for (timing_sample const& s : samples)
+        {
+            double const dx = std::log(double(s.size)) - sum_x / count;
+            double const dy = std::log(s.mean) - sum_y / count;
+            covariance += dx * dy;
+            variance += dx * dx;
+        }
+        return covariance / variance;
+    }
+}    // namespace
+
+double complexity_report::extrapolate(std::uint64_t size) const
+{
+    model_fit const& best = fits.front();
+    return best.coefficient * best.growth(double(size));
+}
+
+complexity_report fit_complexity(std::vector<timing_sample> samples)
+{
+    if (samples.size() < 2)
+    {
+        throw std::runtime_error("fit_complexity: needs at least two sizes");
+    }
+    complexity_report report;
+    for (model const& m : models)
+    {
+        report.fits.push_back(fit(m, samples));
+    }
+    std::stable_sort(report.fits.begin(), report.fits.end(),
+        [](model_fit const& a, model_fit const& b) {
+            return a.error < b.error;
+        });
+    report.exponent = power_law_exponent(samples);
+    report.samples = std::move(samples);
+    return report;
+}
+
+complexity_report measure_complexity(
+    std::function<void(std::uint64_t)> const& kernel, std::uint64_t first,
+    std::uint64_t last, double ratio, unsigned repetitions)
+{
+    if (repetitions < 2 || ratio <= 1)
+    {
+        throw std::runtime_error(
+            "measure_complexity: needs at least two repetitions of a "
+            "growing series");
+    }
+
+    std::vector<std::uint64_t> sizes;
+    for (double size = double(std::max<std::uint64_t>(first, 1));
+         size <= double(last); size *= ratio)
+    {
+        auto n = static_cast<std::uint64_t>(std::llround(size));
+        if (sizes.empty() || n > sizes.back())
+        {
+            sizes.push_back(n);
+        }
+    }
+    if (sizes.size() < 2)
+    {
+        throw std::runtime_error(
+            "measure_complexity: the series needs at least two sizes");
+    }
+
+    std::vector<timing_sample> samples;
+    std::vector<double> times(repetitions);
+    for (std::uint64_t n : sizes)
+    {
+        kernel(n);    // warm up the caches and the branch predictors
+        for (double& t : times)
+        {
+            auto start = std::chrono::steady_clock::now();
+            kernel(n);
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            t = elapsed.count();
+        }
+        samples.push_back(summarize(n, times));
+    }
+    return fit_complexity(std::move(samples));
+}
+
+void write_csv(std::ostream& out, complexity_report const& report)
+{
+    out << "size,mean,ci_low,ci_high";
+    for (model const& m : models)
+    {
+        out << ',' << m.name;
+    }
+    out << '\n';
+
+    for (timing_sample const& s : report.samples)
+    {
+        out << s.size << ',' << s.mean << ',' << s.ci_low << ','
+            << s.ci_high;
+        for (model const& m : models)
+        {
+            auto fitted = std::find_if(report.fits.begin(), report.fits.end(),
+                [&](model_fit const& f) { return f.growth == m.growth; });
+            out << ',' << fitted->coefficient * m.growth(double(s.size));
+        }
+        out << '\n';
+    }
+}
+
+void print_summary(std::ostream& out, complexity_report const& report)
+{
+    std::ios::fmtflags const flags = out.flags();
+    std::streamsize const precision = out.precision();
+    for (model_fit const& f : report.fits)
+    {
+        out << std::left << std::setw(10) << f.name << std::right
+            << "coefficient " << std::scientific << std::setprecision(3)
+            << f.coefficient << " s, error " << std::fixed
+            << std::setprecision(1) << 100 * f.error << "%\n";
+    }
+    out << "power law exponent " << std::setprecision(2) << report.exponent
+        << '\n';
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,65 @@
+// This file declares a harness that measures how the running time of a
+// kernel grows with the input size. It times the kernel over a geometric
+// series of sizes, fits the candidate growth models n, n log n, n^1.5 and
+// n^2 to the timings, and estimates the exponent k of the best power law
+// n^k. A kernel whose exponent drifts from the expected one has a scaling
+// regression, which a single BENCHMARK at one size cannot show.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The timings of a kernel at one size.
+struct timing_sample
+{
+    std::uint64_t size;
+    double mean;        // seconds
+    double ci_low;      // the 95% confidence interval of the mean
+    double ci_high;
+};
+
+// A model t(n) == coefficient * growth(n) fitted to the timings.
+struct model_fit
+{
+    std::string name;
+    double (*growth)(double n);
+    double coefficient;
+    double error;    // the root mean square relative error of the fit
+};
+
+struct complexity_report
+{
+    std::vector<timing_sample> samples;
+    std::vector<model_fit> fits;    // the best fit first
+    double exponent;                // of the power law fitted to log t
+
+    // Returns the running time the best fit predicts for `size`, in
+    // seconds.
+    double extrapolate(std::uint64_t size) const;
+};
+
+// Fit the candidate models and the power law to the given timings, each by
+// least squares on the relative error, which weighs the short timings of
+// small sizes as much as the long ones. Throws a std::runtime_error if
+// there are fewer than two samples.
+complexity_report fit_complexity(std::vector<timing_sample> samples);
+
+// Time kernel(n) for n == first, first * ratio, ... up to `last`, running it
+// once to warm up and then `repetitions` times per size, and fit the
+// timings. Throws a std::runtime_error if the series has fewer than two
+// sizes, if `ratio` isn't greater than 1, or if there are fewer than two
+// repetitions.
+complexity_report measure_complexity(
+    std::function<void(std::uint64_t)> const& kernel, std::uint64_t first,
+    std::uint64_t last, double ratio = 2, unsigned repetitions = 5);
+
+// Write a row per sample holding the size, the mean time and its confidence
+// interval, and the time each model predicts, in seconds.
+void write_csv(std::ostream& out, complexity_report const& report);
+
+// Print the fits from best to worst and the exponent.
+void print_summary(std::ostream& out, complexity_report const& report);
@@ -0,0 +1,39 @@
+// This file implements the interface declared in divisor_summatory.hpp.
+
+#include <cstdint>
+
+#include "divisor_summatory.hpp"
+#include "prime_sieve.hpp"
+
+namespace {
+
+    // Returns 1 + 2 + ... + m, which needs 128 bits for m >= 2^32.
+    unsigned __int128 triangular(std::uint64_t m)
+    {
+        unsigned __int128 const wide = m;
+        return wide * (wide + 1) / 2;
+    }
+}    // namespace
+
+unsigned __int128 divisor_count_summatory(std::uint64_t n)
+{
+    std::uint64_t const s = isqrt(n);
+    unsigned __int128 sum = 0;
+    for (std::uint64_t a = 1; a <= s; ++a)
+    {
+        sum += n / a;
+    }
+    return 2 * sum - static_cast<unsigned __int128>(s) * s;
+}
+
+unsigned __int128 sigma_summatory(std::uint64_t n)
+{
+    std::uint64_t const s = isqrt(n);
+    unsigned __int128 sum = 0;
+    for (std::uint64_t a = 1; a <= s; ++a)
+    {
+        std::uint64_t const q = n / a;
+        sum += static_cast<unsigned __int128>(a) * q + triangular(q);
+    }
+    return sum - s * triangular(s);
+}
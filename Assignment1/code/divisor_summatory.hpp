@@ -0,0 +1,27 @@
+// This file declares the summatory divisor functions, the sums of sigma(k)
+// and of d(k), the number of divisors, over all k up to n. Summing a table
+// of either function takes O(n) time and memory, hopeless for n around
+// 10^12. Dirichlet's hyperbola method gets by with O(sqrt(n)) divisions and
+// no memory at all.
+
+#pragma once
+
+#include <cstdint>
+
+// Returns d(1) + d(2) + ... + d(n) (0 for n == 0). It counts the pairs
+// (a, b) with a * b <= n, which lie under the hyperbola a * b == n. Counting
+// the pairs with a <= sqrt(n), the ones with b <= sqrt(n) and subtracting
+// the square counted twice gives
+//
+//     2 * sum of floor(n / a) for a <= s, minus s^2, where s == floor(sqrt(n)).
+unsigned __int128 divisor_count_summatory(std::uint64_t n);
+
+// Returns sigma(1) + sigma(2) + ... + sigma(n) (0 for n == 0), the sum of a
+// over the same pairs (a, b). Split the same way this is
+//
+//     sum of a * floor(n / a) + T(floor(n / a)) for a <= s, minus s * T(s),
+//
+// where T(m) == m * (m + 1) / 2. The result is close to n^2 * pi^2 / 12,
+// which fits 128 bits for every 64-bit n. Subtracting T(n) gives the sum of
+// the proper divisor sums.
+unsigned __int128 sigma_summatory(std::uint64_t n);
@@ -0,0 +1,493 @@
+// This file implements the interface declared in divisor_sums.hpp.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "divisor_sums.hpp"
+#include "factorize.hpp"
+#include "prime_sieve.hpp"
+#include "search_channel.hpp"
+#include "thread_count.hpp"
+
+namespace {
+
+    // The number of entries of a block of the segmented search. Sieving a
+    // block touches two arrays of 8-byte entries, 2^15 numbers keep both of
+    // them within 512 KiB of L2 cache.
+    constexpr std::uint64_t block_size = 1 << 15;
+
+    void count(number_kind_counts& counts, number_kind kind)
+    {
+        switch (kind)
+        {
+        case number_kind::deficient:
+            ++counts.deficient;
+            break;
+        case number_kind::perfect:
+            ++counts.perfect;
+            break;
+        case number_kind::abundant:
+            ++counts.abundant;
+            break;
+        }
+    }
+
+    // Compute sigma(n) for every n in [lo, lo + sigma.size()), lo > 0.
+    // `primes` has to hold the primes up to the square root of the last
+    // number, `done` (of the same size as `sigma`) is scratch space that
+    // accumulates the part of each number that has been factored so far.
+    void sigma_block(std::uint64_t lo, std::vector<std::uint64_t> const& primes,
+        std::span<std::uint64_t> sigma, std::span<std::uint64_t> done)
+    {
+        std::uint64_t const hi = lo + sigma.size();
+        std::fill(sigma.begin(), sigma.end(), 1);
+        std::fill(done.begin(), done.end(), 1);
+
+        for (std::uint64_t p : primes)
+        {
+            if (p > (hi - 1) / p)
+            {
+                break;
+            }
+
+            for (std::uint64_t m = (lo + p - 1) / p * p; m < hi; m += p)
+            {
+                sigma[m - lo] *= p + 1;
+                done[m - lo] *= p;
+            }
+
+            // The multiples of p^k hold 1 + p + ... + p^(k-1) by now, which
+            // only few numbers need replacing by the next larger sum.
+            std::uint64_t power = p;
+            std::uint64_t sum = p + 1;
+            while (power <= (hi - 1) / p)
+            {
+                power *= p;
+                std::uint64_t next_sum = sum + power;
+                for (std::uint64_t m = (lo + power - 1) / power * power; m < hi;
+                     m += power)
+                {
+                    sigma[m - lo] = sigma[m - lo] / sum * next_sum;
+                    done[m - lo] *= p;
+                }
+                sum = next_sum;
+            }
+        }
+
+        // whatever is left is a single prime factor larger than sqrt(hi)
+        for (std::size_t i = 0; i != sigma.size(); ++i)
+        {
+            std::uint64_t n = lo + i;
+            if (done[i] != n)
+            {
+                sigma[i] *= n / done[i] + 1;
+            }
+        }
+    }
+
+    // The number of numbers divisor_sums tests against the same divisor at
+    // once. 16 32-bit lanes fill an AVX-512 register or two AVX2 ones.
+    constexpr std::size_t batch_lanes = 16;
+
+    // Constants for testing 32-bit numbers for divisibility by d without a
+    // division: n is divisible by d iff rotating n * inverse right by shift
+    // bits gives at most max_quotient, the result is n / d then. For an odd
+    // d the multiplication by its inverse maps the multiples of d onto
+    // 0, 1, 2, ..., so everything else ends up above (2^32 - 1) / d. The
+    // rotation moves the multiples of 2^shift among them back into that
+    // range and everything else out of it.
+    struct divisibility_test
+    {
+        std::uint32_t inverse;         // of the odd part of d modulo 2^32
+        std::uint32_t shift;           // the number of factors 2 in d
+        std::uint32_t max_quotient;    // (2^32 - 1) / d
+    };
+
+    // Returns the divisibility tests for all divisors in [0, stop), the
+    // ones for 0 and 1 are never used.
+    std::vector<divisibility_test> divisibility_tests(std::uint32_t stop)
+    {
+        std::vector<divisibility_test> tests(stop);
+        for (std::uint32_t d = 2; d < stop; ++d)
+        {
+            std::uint32_t shift = std::countr_zero(d);
+            std::uint32_t odd = d >> shift;
+            std::uint32_t inverse = odd;    // correct to 3 bits
+            for (int i = 0; i != 4; ++i)
+            {
+                inverse *= 2 - odd * inverse;
+            }
+            tests[d] = {
+                inverse, shift, std::numeric_limits<std::uint32_t>::max() / d};
+        }
+        return tests;
+    }
+
+    // Adds the divisors d in [2, sqrt(n)] of each number n in the batch and
+    // their cofactors n / d to its entry in `sums`. `limit` has to be at
+    // least the square root of the largest number. Unused lanes hold 0.
+#if defined(__GNUC__) && defined(__x86_64__)
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+    void add_divisors(std::uint32_t const* numbers,
+        divisibility_test const* tests, std::uint32_t limit,
+        std::uint64_t* sums)
+    {
+        // local copies stay in registers, the compiler cannot know that
+        // `sums` doesn't alias the other arrays
+        std::uint32_t n[batch_lanes];
+        std::uint64_t sum[batch_lanes];
+        std::copy(numbers, numbers + batch_lanes, n);
+        std::copy(sums, sums + batch_lanes, sum);
+
+        for (std::uint32_t d = 2; d <= limit; ++d)
+        {
+            divisibility_test const test = tests[d];
+            for (std::size_t i = 0; i != batch_lanes; ++i)
+            {
+                std::uint32_t x = n[i] * test.inverse;
+                std::uint32_t q = (x >> test.shift) |
+                                  (x << ((32 - test.shift) & 31));
+                // q >= d masks out the numbers below d^2, which are done
+                bool divides = q <= test.max_quotient && q >= d;
+                sum[i] += divides ? std::uint64_t(d) + (q != d ? q : 0) : 0;
+            }
+        }
+        std::copy(sum, sum + batch_lanes, sums);
+    }
+
+    // Returns the number of threads to sieve [lo, hi) with, given the number
+    // requested (0 for default_thread_count). There is no point in more
+    // threads than blocks.
+    unsigned thread_count(
+        std::uint64_t lo, std::uint64_t hi, unsigned num_threads)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = default_thread_count();
+        }
+        std::uint64_t num_blocks = (hi - lo + block_size - 1) / block_size;
+        return static_cast<unsigned>(
+            std::min<std::uint64_t>(num_threads, num_blocks));
+    }
+
+    // Sieve [lo, hi) (lo > 0) block by block on `num_threads` threads and
+    // call f(thread, block_lo, sigma) for each block, `thread` being the
+    // index of the calling thread and `sigma` holding sigma(n) for the n in
+    // [block_lo, block_lo + sigma.size()). The threads grab the next block as
+    // soon as they are done with the previous one, the primes up to sqrt(hi)
+    // are shared. Once a stop is requested through `stop` no more blocks
+    // are taken.
+    template <typename F>
+    void sieve_blocks(std::uint64_t lo, std::uint64_t hi, unsigned num_threads,
+        F f, std::stop_token const& stop = {})
+    {
+        std::vector<std::uint64_t> const primes =
+            primes_in(2, isqrt(hi - 1) + 1);
+
+        std::uint64_t num_blocks = (hi - lo + block_size - 1) / block_size;
+        std::atomic<std::uint64_t> next_block(0);
+
+        auto worker = [&](unsigned thread) {
+            std::vector<std::uint64_t> sigma(block_size);
+            std::vector<std::uint64_t> done(block_size);
+
+            for (std::uint64_t block = next_block++;
+                 block < num_blocks && !stop.stop_requested();
+                 block = next_block++)
+            {
+                std::uint64_t block_lo = lo + block * block_size;
+                std::size_t len = std::min(block_size, hi - block_lo);
+                sigma_block(block_lo, primes, std::span(sigma).first(len),
+                    std::span(done).first(len));
+                f(thread, block_lo,
+                    std::span<std::uint64_t const>(sigma).first(len));
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            for (unsigned i = 1; i < num_threads; ++i)
+            {
+                threads.emplace_back(worker, i);
+            }
+            worker(0);
+        }    // joins all threads
+    }
+    // The search behind both search_perfect_numbers, reporting to `channel`
+    // if there is one.
+    perfect_search_result perfect_search(std::uint64_t lo, std::uint64_t hi,
+        std::stop_token const& stop, search_channel* channel,
+        unsigned num_threads)
+    {
+        lo = std::max<std::uint64_t>(lo, 1);
+        if (lo >= hi)
+        {
+            return {};
+        }
+        num_threads = thread_count(lo, hi, num_threads);
+
+        // every thread collects its own results, they are merged in the end
+        std::vector<perfect_search_result> partial(num_threads);
+        // the found numbers waiting for room in the channel, per thread
+        std::vector<std::vector<std::uint64_t>> unsent(num_threads);
+        auto send = [&](std::vector<std::uint64_t>& numbers) {
+            auto sent = std::find_if_not(numbers.begin(), numbers.end(),
+                [&](std::uint64_t n) { return channel->try_push(n); });
+            numbers.erase(numbers.begin(), sent);
+        };
+
+        sieve_blocks(
+            lo, hi, num_threads,
+            [&](unsigned thread, std::uint64_t block_lo,
+                std::span<std::uint64_t const> sigma) {
+                perfect_search_result& found = partial[thread];
+                number_kind_counts block_counts;
+                for (std::size_t i = 0; i != sigma.size(); ++i)
+                {
+                    std::uint64_t n = block_lo + i;
+                    number_kind kind = classify(n, sigma[i] - n);
+                    count(block_counts, kind);
+                    if (kind == number_kind::perfect)
+                    {
+                        found.perfect_numbers.push_back(n);
+                        if (channel)
+                        {
+                            unsent[thread].push_back(n);
+                        }
+                    }
+                }
+                found.counts.deficient += block_counts.deficient;
+                found.counts.perfect += block_counts.perfect;
+                found.counts.abundant += block_counts.abundant;
+                if (channel)
+                {
+                    send(unsent[thread]);
+                    channel->add_counts(block_counts);
+                }
+            },
+            stop);
+
+        perfect_search_result result;
+        for (unsigned thread = 0; thread != num_threads; ++thread)
+        {
+            perfect_search_result const& found = partial[thread];
+            if (channel)
+            {
+                send(unsent[thread]);    // one last try
+            }
+            result.counts.deficient += found.counts.deficient;
+            result.counts.perfect += found.counts.perfect;
+            result.counts.abundant += found.counts.abundant;
+            result.perfect_numbers.insert(result.perfect_numbers.end(),
+                found.perfect_numbers.begin(), found.perfect_numbers.end());
+        }
+        std::sort(
+            result.perfect_numbers.begin(), result.perfect_numbers.end());
+        return result;
+    }
+}    // namespace
+
+std::vector<std::uint64_t> proper_divisor_sums(std::uint64_t stop)
+{
+    // The sieve fills in sigma(n), an entry that is still zero when the loop
+    // gets to it is a prime. For a prime p dividing i (and p being the
+    // smallest prime factor of i)
+    //
+    //     sigma(i * p) == (p + 1) * sigma(i) - p * sigma(i / p)
+    //
+    // otherwise sigma is multiplicative: sigma(i * p) == sigma(i) * (p + 1).
+    std::vector<std::uint64_t> table(stop, 0);
+    std::vector<std::uint64_t> primes;
+
+    if (stop > 1)
+    {
+        table[1] = 1;
+    }
+    for (std::uint64_t i = 2; i < stop; ++i)
+    {
+        if (table[i] == 0)
+        {
+            table[i] = i + 1;
+            primes.push_back(i);
+        }
+        for (std::uint64_t p : primes)
+        {
+            if (p > (stop - 1) / i)
+            {
+                break;
+            }
+            if (i % p == 0)
+            {
+                table[i * p] = (p + 1) * table[i] - p * table[i / p];
+                break;    // i * q has the smallest prime factor p, not q
+            }
+            table[i * p] = table[i] * (p + 1);
+        }
+    }
+
+    for (std::uint64_t n = 1; n < stop; ++n)
+    {
+        table[n] -= n;
+    }
+    return table;
+}
+
+number_kind_counts count_number_kinds(std::vector<std::uint64_t> const& table)
+{
+    number_kind_counts counts;
+    for (std::uint64_t n = 1; n < table.size(); ++n)
+    {
+        count(counts, classify(n, table[n]));
+    }
+    return counts;
+}
+
+std::vector<std::uint64_t> perfect_numbers_below(std::uint64_t stop)
+{
+    std::vector<std::uint64_t> table = proper_divisor_sums(stop);
+
+    std::vector<std::uint64_t> result;
+    for (std::uint64_t n = 1; n < stop; ++n)
+    {
+        if (table[n] == n)
+        {
+            result.push_back(n);
+        }
+    }
+    return result;
+}
+
+perfect_search_result search_perfect_numbers(
+    std::uint64_t lo, std::uint64_t hi, unsigned num_threads)
+{
+    return perfect_search(lo, hi, {}, nullptr, num_threads);
+}
+
+perfect_search_result search_perfect_numbers(std::uint64_t lo,
+    std::uint64_t hi, std::stop_token stop, search_channel& channel,
+    unsigned num_threads)
+{
+    return perfect_search(lo, hi, stop, &channel, num_threads);
+}
+
+void sigma_range(
+    std::uint64_t lo, std::span<std::uint64_t> sigma, unsigned num_threads)
+{
+    if (lo == 0 && !sigma.empty())
+    {
+        sigma[0] = 0;
+        sigma = sigma.subspan(1);
+        lo = 1;
+    }
+    if (sigma.empty())
+    {
+        return;
+    }
+
+    // the threads write to disjoint parts of the output
+    std::uint64_t const hi = lo + sigma.size();
+    sieve_blocks(lo, hi, thread_count(lo, hi, num_threads),
+        [&](unsigned, std::uint64_t block_lo,
+            std::span<std::uint64_t const> block) {
+            std::copy(
+                block.begin(), block.end(), sigma.begin() + (block_lo - lo));
+        });
+}
+
+std::vector<std::uint32_t> clipped_proper_divisor_sums(
+    std::uint64_t stop, unsigned num_threads)
+{
+    if (stop > clipped_sum)
+    {
+        throw std::runtime_error(
+            "clipped_proper_divisor_sums: the range exceeds 32 bits");
+    }
+    std::vector<std::uint32_t> table(stop, 0);
+    if (stop < 2)
+    {
+        return table;
+    }
+
+    // the threads write to disjoint parts of the table
+    sieve_blocks(1, stop, thread_count(1, stop, num_threads),
+        [&](unsigned, std::uint64_t block_lo,
+            std::span<std::uint64_t const> sigma) {
+            for (std::size_t i = 0; i != sigma.size(); ++i)
+            {
+                std::uint64_t n = block_lo + i;
+                std::uint64_t sum = sigma[i] - n;
+                table[n] = sum < stop ? static_cast<std::uint32_t>(sum)
+                                      : clipped_sum;
+            }
+        });
+    return table;
+}
+
+std::vector<std::uint64_t> divisor_sums(std::span<std::int64_t const> numbers)
+{
+    std::vector<std::uint64_t> result(numbers.size(), 0);
+
+    // the numbers that fit 32 bits are batched in increasing order, so that
+    // the numbers of a batch need about as many divisors
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i != numbers.size(); ++i)
+    {
+        std::int64_t n = numbers[i];
+        if (n < 2)
+        {
+            continue;
+        }
+        if (n <= std::numeric_limits<std::uint32_t>::max())
+        {
+            order.push_back(i);
+            continue;
+        }
+        unsigned __int128 sum = sigma64(n) - n;
+        if (sum > std::numeric_limits<std::uint64_t>::max())
+        {
+            throw std::runtime_error(
+                "divisor_sums: the sum of the divisors of " +
+                std::to_string(n) + " does not fit 64 bits");
+        }
+        result[i] = static_cast<std::uint64_t>(sum);
+    }
+    if (order.empty())
+    {
+        return result;
+    }
+    std::sort(order.begin(), order.end(),
+        [&](std::size_t a, std::size_t b) { return numbers[a] < numbers[b]; });
+
+    std::vector<divisibility_test> const tests = divisibility_tests(
+        static_cast<std::uint32_t>(isqrt(numbers[order.back()])) + 1);
+
+    for (std::size_t start = 0; start < order.size(); start += batch_lanes)
+    {
+        std::size_t len = std::min(batch_lanes, order.size() - start);
+        std::uint32_t batch[batch_lanes] = {};
+        std::uint64_t sums[batch_lanes] = {};
+        for (std::size_t i = 0; i != len; ++i)
+        {
+            batch[i] = static_cast<std::uint32_t>(numbers[order[start + i]]);
+            sums[i] = 1;
+        }
+        add_divisors(batch, tests.data(),
+            static_cast<std::uint32_t>(isqrt(batch[len - 1])), sums);
+        for (std::size_t i = 0; i != len; ++i)
+        {
+            result[order[start + i]] = sums[i];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+// This file declares the range engine for the perfect number search. Instead
+// of summing the divisors of one number at a time it computes the sum of the
+// divisors of every number in a range at once, after which classifying any
+// number of the range is a single table lookup.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+class search_channel;
+
+// Returns a table holding the sum of the proper divisors (all divisors except
+// the number itself) of every n in [0, stop), i.e. table[n] == sigma(n) - n.
+// table[0] and table[1] are 0. The table is filled in a single pass of a
+// linear sieve, which visits every composite number exactly once through its
+// smallest prime factor.
+std::vector<std::uint64_t> proper_divisor_sums(std::uint64_t stop);
+
+// A number is deficient, perfect or abundant if the sum of its proper
+// divisors is less than, equal to or greater than the number itself.
+enum class number_kind
+{
+    deficient,
+    perfect,
+    abundant
+};
+
+// Classify `n`, given the sum of its proper divisors.
+inline number_kind classify(std::uint64_t n, std::uint64_t proper_divisor_sum)
+{
+    if (proper_divisor_sum < n)
+    {
+        return number_kind::deficient;
+    }
+    return proper_divisor_sum == n ? number_kind::perfect
+                                   : number_kind::abundant;
+}
+
+// The number of deficient, perfect and abundant numbers in a range.
+struct number_kind_counts
+{
+    std::uint64_t deficient = 0;
+    std::uint64_t perfect = 0;
+    std::uint64_t abundant = 0;
+};
+
+// Count the deficient, perfect and abundant numbers in [1, table.size()),
+// given a table as returned by proper_divisor_sums.
+number_kind_counts count_number_kinds(std::vector<std::uint64_t> const& table);
+
+// Returns the perfect numbers in [1, stop) in increasing order.
+std::vector<std::uint64_t> perfect_numbers_below(std::uint64_t stop);
+
+// The outcome of a search for perfect numbers over a range.
+struct perfect_search_result
+{
+    std::vector<std::uint64_t> perfect_numbers;    // in increasing order
+    number_kind_counts counts;
+};
+
+// Search [lo, hi) for perfect numbers using up to `num_threads` threads (0
+// for default_thread_count), counting the deficient and abundant numbers on
+// the way. The range is cut into blocks that fit into the L2 cache, each of
+// which is sieved from a shared table of the primes up to sqrt(hi). The
+// threads grab the next block as soon as they are done with the previous
+// one. Unlike proper_divisor_sums, the memory used depends on the number of
+// threads and on sqrt(hi) only, not on the size of the range.
+perfect_search_result search_perfect_numbers(
+    std::uint64_t lo, std::uint64_t hi, unsigned num_threads = 0);
+
+// The same search, which can be cancelled through `stop` and reports to
+// `channel` while it runs: the counts after every block and each perfect
+// number found. A number that finds the channel full is offered again after
+// the next block, the workers never wait for the channel to be drained.
+// Numbers still waiting when the search ends are in the result only. Once a
+// stop is requested the threads finish the block at hand and take no more,
+// the result then covers the blocks searched, which need not be contiguous.
+perfect_search_result search_perfect_numbers(std::uint64_t lo,
+    std::uint64_t hi, std::stop_token stop, search_channel& channel,
+    unsigned num_threads = 0);
+
+// Store sigma(n) for every n in [lo, lo + sigma.size()) into `sigma`, with
+// sigma(0) == 0. The range is sieved block by block like in
+// search_perfect_numbers, using up to `num_threads` threads.
+void sigma_range(
+    std::uint64_t lo, std::span<std::uint64_t> sigma, unsigned num_threads = 0);
+
+// The value clipped_proper_divisor_sums stores for sums that are out of range.
+inline constexpr std::uint32_t clipped_sum = 0xffffffff;
+
+// Returns a table like proper_divisor_sums, which takes half the memory by
+// storing 32-bit numbers: table[n] == sigma(n) - n if that is less than
+// `stop`, otherwise table[n] == clipped_sum. For a `stop` larger than
+// 2^32 - 1 this throws a std::runtime_error. The table is sieved
+// block by block like in search_perfect_numbers, using up to `num_threads`
+// threads.
+std::vector<std::uint32_t> clipped_proper_divisor_sums(
+    std::uint64_t stop, unsigned num_threads = 0);
+
+// Returns the sum of the proper divisors of each of the given numbers, 0 for
+// numbers less than 2. Unlike the tables above this is meant for scattered
+// numbers. Numbers below 2^32 are sorted by size and divided by every
+// candidate divisor up to their square root in batches, where all numbers of
+// a batch are tested against the same divisor at once in the lanes of the
+// vector registers. Larger numbers are factored with sigma64. Throws a
+// std::runtime_error if a sum does not fit 64 bits.
+std::vector<std::uint64_t> divisor_sums(std::span<std::int64_t const> numbers);
@@ -0,0 +1,216 @@
+// This file implements the interface declared in factorize.hpp.
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "factorize.hpp"
+#include "montgomery.hpp"
+#include "prime_sieve.hpp"
+
+namespace {
+
+    // Factors below this are found by trial division, which is faster than
+    // Pollard's rho method for them.
+    constexpr std::uint64_t trial_division_limit = 128;
+
+    // Pollard's rho method multiplies this many differences together before
+    // taking a gcd with n, a gcd costs far more than a multiplication.
+    constexpr std::uint64_t gcd_batch_size = 128;
+
+    // Returns whether the odd number n == d * 2^s + 1 (d odd) passes the
+    // Miller-Rabin test to base a.
+    bool is_strong_probable_prime(
+        montgomery const& mod, std::uint64_t a, std::uint64_t d, unsigned s)
+    {
+        std::uint64_t const n = mod.modulus();
+        if (a % n == 0)
+        {
+            return true;
+        }
+        std::uint64_t const one = mod.one();
+        std::uint64_t const minus_one = n - one;
+
+        std::uint64_t x = mod.power(mod.to(a % n), d);
+        if (x == one || x == minus_one)
+        {
+            return true;
+        }
+        for (unsigned i = 1; i < s; ++i)
+        {
+            x = mod.multiply(x, x);
+            if (x == minus_one)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns a nontrivial factor of n, which has to be odd and composite,
+    // following the sequence x -> x^2 + c modulo n. Once it repeats modulo a
+    // prime factor p of n, after about sqrt(p) steps, gcd(x - y, n) reveals
+    // p. Brent's variant compares x with the values after it in blocks of
+    // growing powers of two, multiplying the differences together.
+    std::uint64_t pollard_brent(std::uint64_t n)
+    {
+        montgomery const mod(n);
+        for (std::uint64_t c = 1;; ++c)
+        {
+            // c may as well be in Montgomery form, any constant will do
+            auto step = [&](std::uint64_t x) {
+                return mod.add(mod.multiply(x, x), c);
+            };
+
+            std::uint64_t x = 0;
+            std::uint64_t y = 2;
+            std::uint64_t saved_y = y;
+            std::uint64_t product = mod.one();
+            std::uint64_t factor = 1;
+            for (std::uint64_t length = 1; factor == 1; length *= 2)
+            {
+                x = y;
+                for (std::uint64_t i = 0; i != length; ++i)
+                {
+                    y = step(y);
+                }
+                for (std::uint64_t k = 0; k < length && factor == 1;
+                     k += gcd_batch_size)
+                {
+                    saved_y = y;
+                    std::uint64_t steps = std::min(gcd_batch_size, length - k);
+                    for (std::uint64_t i = 0; i != steps; ++i)
+                    {
+                        y = step(y);
+                        product = mod.multiply(product, mod.subtract(x, y));
+                    }
+                    // 2^64 is coprime to n, the gcd is the same either way
+                    factor = std::gcd(product, n);
+                }
+            }
+
+            // the batch may have collected all factors of n at once, redo it
+            // one step at a time
+            if (factor == n)
+            {
+                do
+                {
+                    saved_y = step(saved_y);
+                    factor = std::gcd(mod.subtract(x, saved_y), n);
+                } while (factor == 1);
+            }
+            if (factor != n)
+            {
+                return factor;
+            }
+        }
+    }
+}    // namespace
+
+bool is_prime64(std::uint64_t n)
+{
+    for (std::uint64_t p : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37})
+    {
+        if (n % p == 0)
+        {
+            return n == p;
+        }
+    }
+    if (n < 41 * 41)
+    {
+        return n > 1;
+    }
+
+    unsigned const s = std::countr_zero(n - 1);
+    std::uint64_t const d = (n - 1) >> s;
+    montgomery const mod(n);
+    // these bases are known to leave no 64-bit composite undetected
+    for (std::uint64_t a :
+        {2, 325, 9375, 28178, 450775, 9780504, 1795265022})
+    {
+        if (!is_strong_probable_prime(mod, a, d, s))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<prime_power> factorize(std::uint64_t n)
+{
+    static std::vector<std::uint64_t> const small_primes =
+        primes_in(2, trial_division_limit);
+
+    std::vector<std::uint64_t> primes;    // with repetitions
+    for (std::uint64_t p : small_primes)
+    {
+        if (p * p > n)
+        {
+            break;
+        }
+        while (n % p == 0)
+        {
+            primes.push_back(p);
+            n /= p;
+        }
+    }
+
+    std::vector<std::uint64_t> unsplit;
+    if (n > 1)
+    {
+        unsplit.push_back(n);
+    }
+    while (!unsplit.empty())
+    {
+        std::uint64_t m = unsplit.back();
+        unsplit.pop_back();
+        if (is_prime64(m))
+        {
+            primes.push_back(m);
+        }
+        else
+        {
+            std::uint64_t factor = pollard_brent(m);
+            unsplit.push_back(factor);
+            unsplit.push_back(m / factor);
+        }
+    }
+    std::sort(primes.begin(), primes.end());
+
+    std::vector<prime_power> result;
+    for (std::uint64_t p : primes)
+    {
+        if (!result.empty() && result.back().prime == p)
+        {
+            ++result.back().exponent;
+        }
+        else
+        {
+            result.push_back({p, 1});
+        }
+    }
+    return result;
+}
+
+unsigned __int128 sigma64(std::uint64_t n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    unsigned __int128 result = 1;
+    for (prime_power const& factor : factorize(n))
+    {
+        unsigned __int128 power = 1;
+        unsigned __int128 sum = 1;
+        for (unsigned i = 0; i != factor.exponent; ++i)
+        {
+            power *= factor.prime;
+            sum += power;
+        }
+        result *= sum;
+    }
+    return result;
+}
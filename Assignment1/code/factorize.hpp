@@ -0,0 +1,31 @@
+// This file declares the factorization of single 64-bit numbers and the
+// divisor sum computed from it. Where trial division needs up to sqrt(n)
+// steps, about 10^9 for numbers near 10^18, Pollard's rho method finds a
+// factor p in about sqrt(p) steps, and a Miller-Rabin test tells when there
+// is nothing left to split.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Returns whether n is prime. The Miller-Rabin test with the bases used is
+// deterministic for all 64-bit numbers.
+bool is_prime64(std::uint64_t n);
+
+// A prime factor and how often it divides a number.
+struct prime_power
+{
+    std::uint64_t prime;
+    unsigned exponent;
+};
+
+// Returns the prime factorization of n in increasing order of the primes
+// (nothing for n < 2). Small factors are found by trial division, larger
+// ones by Brent's variant of Pollard's rho method.
+std::vector<prime_power> factorize(std::uint64_t n);
+
+// Returns the sum of all divisors of n including n itself (0 for n == 0),
+// computed from the factorization as the product of 1 + p + ... + p^e over
+// its prime powers p^e. The sum can exceed 64 bits, hence the wider type.
+unsigned __int128 sigma64(std::uint64_t n);
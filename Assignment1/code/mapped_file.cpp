@@ -0,0 +1,151 @@
+// This file implements the interface declared in mapped_file.hpp.
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+namespace {
+
+    [[noreturn]] void throw_errno(std::string const& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    [[noreturn]] void throw_read_only()
+    {
+        throw std::system_error(
+            std::make_error_code(std::errc::permission_denied),
+            "mapped_file: the file is mapped read-only");
+    }
+}    // namespace
+
+mapped_file::mapped_file(std::string const& path, access mode)
+  : writable(mode == access::read_write)
+{
+    fd = writable ? ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+                  : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw_errno("mapped_file: cannot open " + path);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        throw_errno("mapped_file: cannot stat " + path);
+    }
+    length = static_cast<std::size_t>(status.st_size);
+
+    try
+    {
+        map();
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+  : fd(std::exchange(other.fd, -1))
+  , data(std::exchange(other.data, nullptr))
+  , length(std::exchange(other.length, 0))
+  , writable(other.writable)
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        fd = std::exchange(other.fd, -1);
+        data = std::exchange(other.data, nullptr);
+        length = std::exchange(other.length, 0);
+        writable = other.writable;
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    unmap();
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+void mapped_file::map()
+{
+    // an empty file can't be mapped, there is nothing to access anyway
+    if (length == 0)
+    {
+        return;
+    }
+    int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* address = ::mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        throw_errno("mapped_file: cannot map the file");
+    }
+    data = static_cast<std::byte*>(address);
+}
+
+void mapped_file::unmap()
+{
+    if (data != nullptr)
+    {
+        ::munmap(data, length);
+        data = nullptr;
+    }
+}
+
+std::span<std::byte> mapped_file::mutable_bytes()
+{
+    if (!writable)
+    {
+        throw_read_only();
+    }
+    return {data, length};
+}
+
+void mapped_file::resize(std::size_t size)
+{
+    if (!writable)
+    {
+        throw_read_only();
+    }
+    unmap();
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        throw_errno("mapped_file: cannot resize the file");
+    }
+    length = size;
+    map();
+}
+
+void mapped_file::flush()
+{
+    if (data != nullptr && writable && ::msync(data, length, MS_SYNC) != 0)
+    {
+        throw_errno("mapped_file: cannot write back the file");
+    }
+}
@@ -0,0 +1,57 @@
+// This file declares a file mapped into memory. The operating system pages
+// the contents in on first access and keeps them in its page cache between
+// runs, so opening a large file this way costs next to nothing up front.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+class mapped_file
+{
+    int fd = -1;
+    std::byte* data = nullptr;
+    std::size_t length = 0;
+    bool writable = false;
+
+    void map();
+    void unmap();
+
+public:
+    enum class access
+    {
+        read_only,     // the file has to exist
+        read_write     // the file is created if it doesn't exist
+    };
+
+    // Open and map the file at `path`. Throws a std::system_error if the
+    // file can't be opened or mapped.
+    mapped_file(std::string const& path, access mode);
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    ~mapped_file();
+
+    // Return the size of the file in bytes.
+    std::size_t size() const
+    {
+        return length;
+    }
+
+    std::span<std::byte const> bytes() const
+    {
+        return {data, length};
+    }
+
+    // Return the contents for writing, which requires access::read_write.
+    std::span<std::byte> mutable_bytes();
+
+    // Grow or shrink the file to `size` bytes and map it anew, new bytes
+    // are zero. Requires access::read_write, spans returned before are
+    // invalidated.
+    void resize(std::size_t size);
+
+    // Write the changes made through mutable_bytes back to the file.
+    void flush();
+};
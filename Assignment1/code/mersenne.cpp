@@ -0,0 +1,910 @@
+// This file implements the interface declared in mersenne.hpp.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mersenne.hpp"
+#include "montgomery.hpp"
+#include "prime_sieve.hpp"
+#include "thread_count.hpp"
+
+namespace {
+
+    using word = std::uint64_t;
+    using double_word = unsigned __int128;
+
+    // Exponents from this one on are tested with the FFT, below it squaring
+    // word by word is faster.
+    constexpr unsigned fft_threshold = 3500;
+
+    // If a convolution output of the FFT is further than this from an
+    // integer it may have been rounded to the wrong one. The test is then
+    // redone squaring word by word.
+    constexpr double max_roundoff_error = 0.4;
+
+    // Store the square of the n words in `a` into the 2n words of `r`.
+    void square(word const* a, std::size_t n, word* r)
+    {
+        std::fill(r, r + 2 * n, 0);
+
+        // the products a[i] * a[j] with i != j appear twice in the square
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            word carry = 0;
+            for (std::size_t j = i + 1; j != n; ++j)
+            {
+                double_word t = double_word(a[i]) * a[j] + r[i + j] + carry;
+                r[i + j] = word(t);
+                carry = word(t >> 64);
+            }
+            r[i + n] = carry;
+        }
+
+        word shifted_out = 0;
+        for (std::size_t k = 0; k != 2 * n; ++k)
+        {
+            word v = r[k];
+            r[k] = (v << 1) | shifted_out;
+            shifted_out = v >> 63;
+        }
+
+        word carry = 0;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            double_word t = double_word(a[i]) * a[i];
+            double_word low = double_word(r[2 * i]) + word(t) + carry;
+            r[2 * i] = word(low);
+            double_word high =
+                double_word(r[2 * i + 1]) + word(t >> 64) + word(low >> 64);
+            r[2 * i + 1] = word(high);
+            carry = word(high >> 64);
+        }
+    }
+
+    // The Lucas-Lehmer test for an odd prime p, squaring word by word. As
+    // 2^p == 1 modulo 2^p - 1, the square is reduced by adding the bits above
+    // bit p to the bits below it.
+    bool lucas_lehmer_words(unsigned p)
+    {
+        std::size_t const n = (p + 63) / 64;
+        unsigned const shift = p % 64;
+        std::size_t const top = p / 64;    // the word holding bit p
+        word const top_mask = shift == 0 ? ~word(0) : (word(1) << shift) - 1;
+
+        std::vector<word> s(n, 0);
+        std::vector<word> sq(2 * n);
+        s[0] = 4;
+
+        for (unsigned i = 2; i != p; ++i)
+        {
+            square(s.data(), n, sq.data());
+
+            // s = (sq mod 2^p) + (sq >> p), which is less than 2^(p+1)
+            double_word sum = 0;
+            for (std::size_t k = 0; k != n; ++k)
+            {
+                word high = shift == 0 ? sq[top + k]
+                                       : (sq[top + k] >> shift) |
+                        (sq[top + k + 1] << (64 - shift));
+                word low = k == n - 1 ? sq[k] & top_mask : sq[k];
+                sum += double_word(low) + high;
+                s[k] = word(sum);
+                sum >>= 64;
+            }
+
+            // fold bit p back in
+            word overflow = shift == 0 ? word(sum) : s[n - 1] >> shift;
+            s[n - 1] &= top_mask;
+            for (std::size_t k = 0; overflow != 0 && k != n; ++k)
+            {
+                s[k] += overflow;
+                overflow = s[k] < overflow ? 1 : 0;
+            }
+
+            word borrow = 2;
+            for (std::size_t k = 0; borrow != 0 && k != n; ++k)
+            {
+                word v = s[k];
+                s[k] = v - borrow;
+                borrow = v < borrow ? 1 : 0;
+            }
+            if (borrow != 0)
+            {
+                // s was 0 or 1, s - 2 + (2^p - 1) is s - 3 modulo 2^p
+                s[n - 1] &= top_mask;
+                for (std::size_t k = 0; k != n; ++k)
+                {
+                    if (s[k]-- != 0)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // 0 has two representations: 0 and 2^p - 1
+        bool zero = std::all_of(
+            s.begin(), s.end(), [](word w) { return w == 0; });
+        bool all_ones =
+            std::all_of(s.begin(), s.end() - 1,
+                [](word w) { return w == ~word(0); }) &&
+            s[n - 1] == top_mask;
+        return zero || all_ones;
+    }
+
+    // Squares numbers modulo 2^p - 1 with the irrational base discrete
+    // weighted transform of Crandall and Fagin. The number is stored in
+    // `size` words holding floor(p / size) or ceil(p / size) bits each as
+    // balanced (possibly negative) digits in doubles. Multiplying word j
+    // with 2^(ceil(p*j/size) - p*j/size) turns the cyclic convolution
+    // computed by the FFT into a multiplication modulo 2^p - 1, so there is
+    // neither zero padding nor a separate reduction step. The digits are
+    // real, which allows computing the transform of length `size` with a
+    // complex FFT of half that length.
+    class weighted_square
+    {
+        // The complex numbers e^(-2*pi*i*j/(4q)), j < q, used by the FFT
+        // pass that combines blocks of length q, raised to the first, second
+        // and third power. The values for q are stored at [q, 2q).
+        struct twiddles
+        {
+            std::vector<double> re1, im1, re2, im2, re3, im3;
+        };
+
+        std::size_t size;    // number of words, a power of two
+        std::size_t half;    // length of the complex FFT
+        std::vector<double> weight;
+        std::vector<double> unweight;    // 1 / (weight * half)
+        std::vector<double> base;        // 2^(bits of the word)
+        std::vector<double> inv_base;
+        twiddles twiddle;
+        // e^(-2*pi*i*k/size) for splitting and merging the real transform
+        std::vector<double> split_re, split_im;
+        std::vector<std::size_t> reversed;    // bit reversal permutation
+        std::vector<double> re, im;           // FFT buffers
+        std::vector<double> carries, second_carries;
+
+        // Decimation in frequency, the result is in bit reversed order. Two
+        // radix-2 stages are done per pass over the data (radix 2^2), which
+        // leaves the order of the result as it is but saves a quarter of the
+        // multiplications.
+        void fft_forward()
+        {
+            double* r = re.data();
+            double* i = im.data();
+            std::size_t h = half / 2;
+            for (; h >= 2; h /= 4)
+            {
+                std::size_t const q = h / 2;
+                double const* wr1 = twiddle.re1.data() + q;
+                double const* wi1 = twiddle.im1.data() + q;
+                double const* wr2 = twiddle.re2.data() + q;
+                double const* wi2 = twiddle.im2.data() + q;
+                double const* wr3 = twiddle.re3.data() + q;
+                double const* wi3 = twiddle.im3.data() + q;
+                for (std::size_t start = 0; start != half; start += 4 * q)
+                {
+                    double* ar = r + start;
+                    double* ai = i + start;
+                    double* br = ar + q;
+                    double* bi = ai + q;
+                    double* cr = br + q;
+                    double* ci = bi + q;
+                    double* dr = cr + q;
+                    double* di = ci + q;
+                    for (std::size_t j = 0; j != q; ++j)
+                    {
+                        double s0r = ar[j] + cr[j], s0i = ai[j] + ci[j];
+                        double s1r = br[j] + dr[j], s1i = bi[j] + di[j];
+                        double d0r = ar[j] - cr[j], d0i = ai[j] - ci[j];
+                        double d1r = br[j] - dr[j], d1i = bi[j] - di[j];
+
+                        ar[j] = s0r + s1r;
+                        ai[j] = s0i + s1i;
+                        double tr = s0r - s1r, ti = s0i - s1i;
+                        br[j] = tr * wr2[j] - ti * wi2[j];
+                        bi[j] = tr * wi2[j] + ti * wr2[j];
+                        tr = d0r + d1i;    // (a - c) - i(b - d)
+                        ti = d0i - d1r;
+                        cr[j] = tr * wr1[j] - ti * wi1[j];
+                        ci[j] = tr * wi1[j] + ti * wr1[j];
+                        tr = d0r - d1i;    // (a - c) + i(b - d)
+                        ti = d0i + d1r;
+                        dr[j] = tr * wr3[j] - ti * wi3[j];
+                        di[j] = tr * wi3[j] + ti * wr3[j];
+                    }
+                }
+            }
+            if (h == 1)    // an odd number of stages, one is left
+            {
+                for (std::size_t k = 0; k != half; k += 2)
+                {
+                    double tr = r[k] - r[k + 1], ti = i[k] - i[k + 1];
+                    r[k] += r[k + 1];
+                    i[k] += i[k + 1];
+                    r[k + 1] = tr;
+                    i[k + 1] = ti;
+                }
+            }
+        }
+
+        // Decimation in time with conjugated twiddles, the passes of
+        // fft_forward run backwards. Takes its input in bit reversed order,
+        // the result is scaled by `half`.
+        void fft_inverse()
+        {
+            double* r = re.data();
+            double* i = im.data();
+            std::size_t q = 1;
+            if (std::countr_zero(half) % 2 != 0)
+            {
+                for (std::size_t k = 0; k != half; k += 2)
+                {
+                    double tr = r[k] - r[k + 1], ti = i[k] - i[k + 1];
+                    r[k] += r[k + 1];
+                    i[k] += i[k + 1];
+                    r[k + 1] = tr;
+                    i[k + 1] = ti;
+                }
+                q = 2;
+            }
+            for (; q < half; q *= 4)
+            {
+                double const* wr1 = twiddle.re1.data() + q;
+                double const* wi1 = twiddle.im1.data() + q;
+                double const* wr2 = twiddle.re2.data() + q;
+                double const* wi2 = twiddle.im2.data() + q;
+                double const* wr3 = twiddle.re3.data() + q;
+                double const* wi3 = twiddle.im3.data() + q;
+                for (std::size_t start = 0; start != half; start += 4 * q)
+                {
+                    double* ar = r + start;
+                    double* ai = i + start;
+                    double* br = ar + q;
+                    double* bi = ai + q;
+                    double* cr = br + q;
+                    double* ci = bi + q;
+                    double* dr = cr + q;
+                    double* di = ci + q;
+                    for (std::size_t j = 0; j != q; ++j)
+                    {
+                        double xbr = br[j] * wr2[j] + bi[j] * wi2[j];
+                        double xbi = bi[j] * wr2[j] - br[j] * wi2[j];
+                        double xcr = cr[j] * wr1[j] + ci[j] * wi1[j];
+                        double xci = ci[j] * wr1[j] - cr[j] * wi1[j];
+                        double xdr = dr[j] * wr3[j] + di[j] * wi3[j];
+                        double xdi = di[j] * wr3[j] - dr[j] * wi3[j];
+
+                        double s0r = ar[j] + xbr, s0i = ai[j] + xbi;
+                        double d0r = ar[j] - xbr, d0i = ai[j] - xbi;
+                        double s1r = xcr + xdr, s1i = xci + xdi;
+                        double d1r = xcr - xdr, d1i = xci - xdi;
+
+                        ar[j] = s0r + s1r;
+                        ai[j] = s0i + s1i;
+                        cr[j] = s0r - s1r;
+                        ci[j] = s0i - s1i;
+                        br[j] = d0r - d1i;    // d0 + i d1
+                        bi[j] = d0i + d1r;
+                        dr[j] = d0r + d1i;    // d0 - i d1
+                        di[j] = d0i - d1r;
+                    }
+                }
+            }
+        }
+
+        // Given the entries k and half - k of the complex transform of the
+        // even and odd digits (z and z_mirror), square the entries k and
+        // k + half of the real transform and return the matching entry k of
+        // the complex transform of the square.
+        void square_pair(double zr, double zi, double mr, double mi,
+            std::size_t k, double& out_re, double& out_im) const
+        {
+            // even = (z + conj(mirror)) / 2, odd = (z - conj(mirror)) / 2i
+            double even_re = (zr + mr) * 0.5;
+            double even_im = (zi - mi) * 0.5;
+            double odd_re = (zi + mi) * 0.5;
+            double odd_im = (mr - zr) * 0.5;
+
+            double wr = split_re[k];
+            double wi = split_im[k];
+            double t_re = odd_re * wr - odd_im * wi;
+            double t_im = odd_re * wi + odd_im * wr;
+
+            double x0_re = even_re + t_re;
+            double x0_im = even_im + t_im;
+            double x1_re = even_re - t_re;
+            double x1_im = even_im - t_im;
+            double y0_re = x0_re * x0_re - x0_im * x0_im;
+            double y0_im = 2 * x0_re * x0_im;
+            double y1_re = x1_re * x1_re - x1_im * x1_im;
+            double y1_im = 2 * x1_re * x1_im;
+
+            // and back: even = (y0 + y1) / 2, odd = (y0 - y1) / 2w
+            even_re = (y0_re + y1_re) * 0.5;
+            even_im = (y0_im + y1_im) * 0.5;
+            double d_re = (y0_re - y1_re) * 0.5;
+            double d_im = (y0_im - y1_im) * 0.5;
+            odd_re = d_re * wr + d_im * wi;
+            odd_im = d_im * wr - d_re * wi;
+
+            out_re = even_re - odd_im;
+            out_im = even_im + odd_re;
+        }
+
+    public:
+        weighted_square(unsigned p, std::size_t size)
+          : size(size)
+          , half(size / 2)
+          , weight(size)
+          , unweight(size)
+          , base(size)
+          , inv_base(size)
+          , split_re(half)
+          , split_im(half)
+          , reversed(half)
+          , re(half)
+          , im(half)
+          , carries(size)
+          , second_carries(size)
+        {
+            for (std::size_t j = 0; j != size; ++j)
+            {
+                std::uint64_t first_bit =
+                    (std::uint64_t(p) * j + size - 1) / size;
+                std::uint64_t next_bit =
+                    (std::uint64_t(p) * (j + 1) + size - 1) / size;
+                weight[j] = std::exp2(static_cast<double>(first_bit) -
+                    static_cast<double>(p) * j / size);
+                unweight[j] = 1.0 / (weight[j] * half);
+                base[j] =
+                    std::ldexp(1.0, static_cast<int>(next_bit - first_bit));
+                inv_base[j] = 1.0 / base[j];
+            }
+
+            for (auto* table : {&twiddle.re1, &twiddle.im1, &twiddle.re2,
+                     &twiddle.im2, &twiddle.re3, &twiddle.im3})
+            {
+                table->resize(half);
+            }
+            for (std::size_t q = 1; q < half; q *= 2)
+            {
+                for (std::size_t j = 0; j != q; ++j)
+                {
+                    double angle = -2 * std::numbers::pi * j / (4 * q);
+                    twiddle.re1[q + j] = std::cos(angle);
+                    twiddle.im1[q + j] = std::sin(angle);
+                    twiddle.re2[q + j] = std::cos(2 * angle);
+                    twiddle.im2[q + j] = std::sin(2 * angle);
+                    twiddle.re3[q + j] = std::cos(3 * angle);
+                    twiddle.im3[q + j] = std::sin(3 * angle);
+                }
+            }
+            for (std::size_t k = 0; k != half; ++k)
+            {
+                double angle = -2 * std::numbers::pi * k / size;
+                split_re[k] = std::cos(angle);
+                split_im[k] = std::sin(angle);
+            }
+
+            int const bits = std::countr_zero(half);
+            for (std::size_t i = 0; i != half; ++i)
+            {
+                std::size_t r = 0;
+                for (int b = 0; b != bits; ++b)
+                {
+                    r |= ((i >> b) & 1) << (bits - 1 - b);
+                }
+                reversed[i] = r;
+            }
+        }
+
+        // Replace the digits in x by x^2 - 2 modulo 2^p - 1. Returns the
+        // largest distance of a convolution output from the nearest integer.
+        double square_minus_2(std::vector<double>& x)
+        {
+            // (v + round) - round rounds v to the nearest integer
+            constexpr double round = 6755399441055744.0;    // 1.5 * 2^52
+
+            for (std::size_t j = 0; j != half; ++j)
+            {
+                re[j] = x[2 * j] * weight[2 * j];
+                im[j] = x[2 * j + 1] * weight[2 * j + 1];
+            }
+
+            fft_forward();
+            for (std::size_t k = 0; k <= half / 2; ++k)
+            {
+                std::size_t mirror = (half - k) & (half - 1);
+                std::size_t at = reversed[k];
+                std::size_t mirror_at = reversed[mirror];
+                double zr = re[at], zi = im[at];
+                double mr = re[mirror_at], mi = im[mirror_at];
+                square_pair(zr, zi, mr, mi, k, re[at], im[at]);
+                square_pair(
+                    mr, mi, zr, zi, mirror, re[mirror_at], im[mirror_at]);
+            }
+            fft_inverse();
+
+            // Round, then split each output into a digit and a carry into the
+            // next word in two rounds, which leaves carries small enough to
+            // be added to the digits without breaking the FFT's precision.
+            // None of the loops depends on the result of its last iteration.
+            double error = 0;
+            for (std::size_t j = 0; j != half; ++j)
+            {
+                double v0 = re[j] * unweight[2 * j];
+                double v1 = im[j] * unweight[2 * j + 1];
+                double r0 = (v0 + round) - round;
+                double r1 = (v1 + round) - round;
+                error = std::max(
+                    error, std::max(std::abs(v0 - r0), std::abs(v1 - r1)));
+
+                double c0 = (r0 * inv_base[2 * j] + round) - round;
+                double c1 = (r1 * inv_base[2 * j + 1] + round) - round;
+                x[2 * j] = r0 - c0 * base[2 * j];
+                x[2 * j + 1] = r1 - c1 * base[2 * j + 1];
+                carries[2 * j] = c0;
+                carries[2 * j + 1] = c1;
+            }
+
+            // the carry out of the top word wraps around, as 2^p == 1
+            double t = x[0] + carries[size - 1] - 2;
+            double c = (t * inv_base[0] + round) - round;
+            x[0] = t - c * base[0];
+            second_carries[0] = c;
+            for (std::size_t j = 1; j != size; ++j)
+            {
+                t = x[j] + carries[j - 1];
+                c = (t * inv_base[j] + round) - round;
+                x[j] = t - c * base[j];
+                second_carries[j] = c;
+            }
+
+            x[0] += second_carries[size - 1];
+            for (std::size_t j = 1; j != size; ++j)
+            {
+                x[j] += second_carries[j - 1];
+            }
+
+            // anything that went wrong ends up in every output of the FFT
+            return std::isfinite(x[0]) ? error
+                                       : std::numeric_limits<double>::infinity();
+        }
+
+        // Returns whether the digits in x represent 0 modulo 2^p - 1.
+        bool is_zero(std::vector<double> x) const
+        {
+            // normalize to digits in [0, base), then 0 is either all zeros
+            // or all ones (2^p - 1)
+            double carry = 0;
+            do
+            {
+                for (std::size_t j = 0; j != size; ++j)
+                {
+                    double v = x[j] + carry;
+                    carry = std::floor(v * inv_base[j]);
+                    x[j] = v - carry * base[j];
+                }
+            } while (carry != 0);
+
+            bool zero = true;
+            bool all_ones = true;
+            for (std::size_t j = 0; j != size; ++j)
+            {
+                zero = zero && x[j] == 0;
+                all_ones = all_ones && x[j] == base[j] - 1;
+            }
+            return zero || all_ones;
+        }
+    };
+
+    // Returns the number of words the FFT needs for the given exponent. The
+    // doubles have 53 bits of precision, the products of two digits need
+    // twice their bits plus the bits of the number of summands. Taking the
+    // smallest size that fits also keeps the words large enough (10 bits or
+    // more for exponents from fft_threshold on) for the two rounds of carry
+    // propagation in weighted_square::square_minus_2.
+    std::size_t fft_size(unsigned p)
+    {
+        std::size_t size = 64;
+        unsigned log_size = 6;
+        while (2.0 * p / size > 53.0 - log_size)
+        {
+            size *= 2;
+            ++log_size;
+        }
+        return size;
+    }
+
+    // The Lucas-Lehmer test for an odd prime p, squaring with the FFT.
+    bool lucas_lehmer_fft(unsigned p)
+    {
+        std::size_t const size = fft_size(p);
+        weighted_square squarer(p, size);
+        std::vector<double> x(size, 0.0);
+        x[0] = 4;
+
+        for (unsigned i = 2; i != p; ++i)
+        {
+            if (!(squarer.square_minus_2(x) <= max_roundoff_error))
+            {
+                return lucas_lehmer_words(p);
+            }
+        }
+        return squarer.is_zero(x);
+    }
+
+    // Trial factoring computes 2^p mod q for this many candidate factors q
+    // together. The exponentiations are independent of each other and share
+    // the exponent, interleaving them keeps the multiplier busy while each
+    // one waits for its previous product.
+    constexpr std::size_t factor_batch_size = 16;
+
+    // The candidate factors are sieved in chunks of this many for each of
+    // the two residue classes modulo 8p they can be in.
+    constexpr std::size_t factor_chunk_size = 1 << 15;
+
+    // Candidates divisible by an odd prime below this are sieved out, they
+    // cannot be the smallest factor.
+    constexpr unsigned factor_sieve_limit = 1000;
+
+    // Returns the largest multiplier k worth trying for the exponent p. A
+    // factor between 2^b and 2^(b+1) exists with a probability of about 1/b,
+    // while the number of candidates in that range doubles with every b, the
+    // Lucas-Lehmer test costs about p^2 log p. Both balance out around
+    // k == p^2 / log p. Candidates have to fit into 63 bits and must not
+    // exceed sqrt(2^p - 1), which in particular keeps 2^p - 1 itself out.
+    std::uint64_t trial_factor_limit(unsigned p)
+    {
+        std::uint64_t limit = std::uint64_t(p) * p / (4 * std::bit_width(p));
+        unsigned max_bits = std::min(63u, p / 2);
+        return std::min(limit, ((std::uint64_t(1) << max_bits) - 2) / (2 * p));
+    }
+
+    // Returns the first of the numbers in `q` that divides 2^p - 1, or 0 if
+    // none of them does. The numbers have to be odd and larger than 1.
+    std::uint64_t find_mersenne_divisor(
+        unsigned p, std::vector<std::uint64_t> const& q)
+    {
+        std::vector<montgomery> mod;
+        std::vector<std::uint64_t> x;
+        mod.reserve(q.size());
+        x.reserve(q.size());
+        for (std::uint64_t n : q)
+        {
+            mod.emplace_back(n);
+            x.push_back(mod.back().add(mod.back().one(), mod.back().one()));
+        }
+
+        // left to right over the bits of p, starting after the leading one
+        for (int bit = std::bit_width(p) - 2; bit >= 0; --bit)
+        {
+            for (std::size_t i = 0; i != q.size(); ++i)
+            {
+                x[i] = mod[i].multiply(x[i], x[i]);
+            }
+            if ((p >> bit) & 1)
+            {
+                for (std::size_t i = 0; i != q.size(); ++i)
+                {
+                    x[i] = mod[i].add(x[i], x[i]);
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i != q.size(); ++i)
+        {
+            if (x[i] == mod[i].one())
+            {
+                return q[i];
+            }
+        }
+        return 0;
+    }
+
+    // Returns x such that a * x == 1 mod m, for a and m coprime.
+    std::uint64_t inverse_mod(std::uint64_t a, std::uint64_t m)
+    {
+        std::int64_t x = 0;
+        std::int64_t next_x = 1;
+        std::uint64_t r = m;
+        std::uint64_t next_r = a % m;
+        while (next_r != 0)
+        {
+            std::uint64_t quotient = r / next_r;
+            x = std::exchange(next_x, x - std::int64_t(quotient) * next_x);
+            r = std::exchange(next_r, r - quotient * next_r);
+        }
+        return x < 0 ? x + m : x;
+    }
+
+    // Returns the smallest factor 2kp + 1 of 2^p - 1 with 1 <= k <= max_k,
+    // or 0 if there is none. p has to be an odd prime. Only the candidates
+    // that are 1 or 7 modulo 8 and not divisible by a small prime are tested.
+    std::uint64_t trial_factor(unsigned p, std::uint64_t max_k)
+    {
+        static std::vector<std::uint64_t> const sieve_primes =
+            primes_in(3, factor_sieve_limit);
+
+        // 2kp + 1 == +-1 mod 8 iff kp == 0 or 3 mod 4, i.e. k == 4 or 3p mod
+        // 4 (p is its own inverse modulo 4). Writing k == 4j + c turns the
+        // candidates into the two classes q == 8pj + 2cp + 1, the smaller c
+        // comes first for the candidates to be tested in increasing order.
+        std::uint64_t const step = 8 * std::uint64_t(p);
+        std::uint64_t const c[2] = {(3 * p) % 4, 4};
+        std::uint64_t offset[2];
+        std::uint64_t num_j[2];
+        for (int i = 0; i != 2; ++i)
+        {
+            offset[i] = 2 * c[i] * p + 1;
+            num_j[i] = max_k < c[i] ? 0 : (max_k - c[i]) / 4 + 1;
+        }
+
+        // 8pj + o == 0 mod r iff j == -o * (8p)^-1 mod r, but r itself is a
+        // candidate if it happens to be of the form 8pj + o
+        struct excluded_class
+        {
+            std::uint64_t r;
+            std::uint64_t residue[2];
+            std::uint64_t first_j[2];
+        };
+        std::vector<excluded_class> excluded;
+        for (std::uint64_t r : sieve_primes)
+        {
+            if (r == p)
+            {
+                continue;
+            }
+            excluded_class e = {r, {}, {}};
+            std::uint64_t step_inverse = inverse_mod(step % r, r);
+            for (int i = 0; i != 2; ++i)
+            {
+                e.residue[i] = (r - offset[i] % r) * step_inverse % r;
+                e.first_j[i] = r < offset[i] ? 0 : (r - offset[i]) / step + 1;
+            }
+            excluded.push_back(e);
+        }
+
+        std::vector<char> candidate[2] = {std::vector<char>(factor_chunk_size),
+            std::vector<char>(factor_chunk_size)};
+        std::vector<std::uint64_t> batch;
+        batch.reserve(factor_batch_size);
+        auto test_batch = [&] {
+            std::uint64_t q = find_mersenne_divisor(p, batch);
+            batch.clear();
+            return q;
+        };
+
+        // the first class has at least as many candidates as the second
+        for (std::uint64_t lo = 0; lo < num_j[0]; lo += factor_chunk_size)
+        {
+            std::uint64_t hi = std::min(lo + factor_chunk_size, num_j[0]);
+            for (int i = 0; i != 2; ++i)
+            {
+                auto end = candidate[i].begin() +
+                    (std::clamp(num_j[i], lo, hi) - lo);
+                std::fill(candidate[i].begin(), end, true);
+                std::fill(end, candidate[i].end(), false);
+                for (excluded_class const& e : excluded)
+                {
+                    std::uint64_t j = std::max(lo, e.first_j[i]);
+                    j += (e.residue[i] + e.r - j % e.r) % e.r;
+                    for (; j < hi; j += e.r)
+                    {
+                        candidate[i][j - lo] = false;
+                    }
+                }
+            }
+
+            for (std::uint64_t j = lo; j != hi; ++j)
+            {
+                for (int i = 0; i != 2; ++i)
+                {
+                    if (candidate[i][j - lo])
+                    {
+                        batch.push_back(step * j + offset[i]);
+                        if (batch.size() == factor_batch_size)
+                        {
+                            if (std::uint64_t q = test_batch())
+                            {
+                                return q;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return batch.empty() ? 0 : test_batch();
+    }
+
+    // Returns the words of the perfect number 2^(p-1) * (2^p - 1), which is
+    // p ones followed by p - 1 zeros in binary, least significant first.
+    std::vector<word> perfect_number_words(unsigned p)
+    {
+        std::size_t bits = 2 * std::size_t(p) - 1;
+        std::vector<word> words((bits + 63) / 64, 0);
+        for (std::size_t bit = p - 1; bit != bits; ++bit)
+        {
+            words[bit / 64] |= word(1) << (bit % 64);
+        }
+        return words;
+    }
+
+    std::string to_hex(std::vector<word> const& words)
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::string result;
+        for (std::size_t i = words.size(); i-- != 0;)
+        {
+            for (int shift = 60; shift >= 0; shift -= 4)
+            {
+                char digit = digits[(words[i] >> shift) & 0xf];
+                if (!result.empty() || digit != '0')
+                {
+                    result += digit;
+                }
+            }
+        }
+        return result.empty() ? "0" : result;
+    }
+
+    std::string to_decimal(std::vector<word> words)
+    {
+        // divide by 10^19 (the largest power of 10 fitting into a word)
+        // until nothing is left, collecting the remainders
+        constexpr word chunk = 10000000000000000000ull;
+        std::vector<word> chunks;
+        while (!words.empty())
+        {
+            word remainder = 0;
+            for (std::size_t i = words.size(); i-- != 0;)
+            {
+                double_word v = (double_word(remainder) << 64) | words[i];
+                words[i] = word(v / chunk);
+                remainder = word(v % chunk);
+            }
+            chunks.push_back(remainder);
+            while (!words.empty() && words.back() == 0)
+            {
+                words.pop_back();
+            }
+        }
+
+        std::string result =
+            chunks.empty() ? "0" : std::to_string(chunks.back());
+        for (std::size_t i = chunks.size() - 1; i-- != 0;)
+        {
+            std::string digits = std::to_string(chunks[i]);
+            result.append(19 - digits.size(), '0');
+            result += digits;
+        }
+        return result;
+    }
+
+    void check_base(unsigned base)
+    {
+        if (base != 10 && base != 16)
+        {
+            throw std::runtime_error(
+                "unsupported base for perfect numbers: " +
+                std::to_string(base));
+        }
+    }
+}    // namespace
+
+bool is_mersenne_prime(unsigned p)
+{
+    if (!is_prime(p))
+    {
+        return false;    // 2^(ab) - 1 is divisible by 2^a - 1
+    }
+    if (p == 2)
+    {
+        return true;
+    }
+    if (trial_factor(p, trial_factor_limit(p)) != 0)
+    {
+        return false;
+    }
+    return p < fft_threshold ? lucas_lehmer_words(p) : lucas_lehmer_fft(p);
+}
+
+std::uint64_t mersenne_factor(unsigned p)
+{
+    if (p == 2 || !is_prime(p))
+    {
+        return 0;
+    }
+    return trial_factor(p, trial_factor_limit(p));
+}
+
+std::vector<unsigned> mersenne_prime_exponents(
+    unsigned count, unsigned num_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = default_thread_count();
+    }
+
+    // The threads take the candidates in increasing order, but finish them
+    // in any order. The results of candidates above the first one still
+    // being tested wait in `finished`.
+    std::mutex mutex;
+    std::vector<unsigned> result;
+    std::map<unsigned, bool> finished;
+    unsigned next_unfinished = 2;
+    std::atomic<unsigned> next_candidate(2);
+    std::atomic<bool> done(count == 0);
+
+    auto worker = [&]() {
+        while (!done)
+        {
+            unsigned p = next_candidate++;
+            bool prime = is_mersenne_prime(p);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finished[p] = prime;
+            for (auto it = finished.begin();
+                 it != finished.end() && it->first == next_unfinished;
+                 it = finished.erase(it))
+            {
+                ++next_unfinished;
+                if (it->second && result.size() != count)
+                {
+                    result.push_back(it->first);
+                }
+            }
+            if (result.size() == count)
+            {
+                done = true;
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned i = 1; i < num_threads; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+    }    // joins all threads
+
+    return result;
+}
+
+std::string perfect_number_string(unsigned p, unsigned base)
+{
+    check_base(base);
+    if (p == 0)
+    {
+        return "0";
+    }
+    std::vector<word> words = perfect_number_words(p);
+    return base == 16 ? to_hex(words) : to_decimal(std::move(words));
+}
+
+std::string nth_perfect_number(unsigned n, unsigned base, unsigned num_threads)
+{
+    if (n == 0)
+    {
+        throw std::runtime_error("nth_perfect_number: n starts at 1");
+    }
+    check_base(base);
+    std::vector<unsigned> exponents = mersenne_prime_exponents(n, num_threads);
+    return perfect_number_string(exponents.back(), base);
+}
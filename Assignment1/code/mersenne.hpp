@@ -0,0 +1,46 @@
+// This file declares the search for even perfect numbers through Mersenne
+// primes. By the Euclid-Euler theorem the even perfect numbers are exactly
+// the numbers 2^(p-1) * (2^p - 1) for which 2^p - 1 is prime, and whether
+// it is can be decided by the Lucas-Lehmer test. The numbers involved
+// quickly outgrow any built-in type, they are handled as arrays of words.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Returns whether the Mersenne number 2^p - 1 is prime. Composite exponents
+// are rejected right away, as are prime exponents for which mersenne_factor
+// finds a factor. The remaining ones go through the Lucas-Lehmer test: p - 2
+// squarings modulo 2^p - 1. Small numbers are squared word by word and
+// reduced by adding the high half of the square to its low half (as 2^p == 1
+// modulo 2^p - 1), larger ones are squared with a weighted floating point
+// FFT that performs the reduction as part of the convolution.
+bool is_mersenne_prime(unsigned p);
+
+// Returns a factor of 2^p - 1 found by trial division, or 0 if there is none
+// among the candidates tried (in which case 2^p - 1 may still be composite).
+// For a prime p every factor of 2^p - 1 has the form 2kp + 1 and is 1 or 7
+// modulo 8. The candidates are tested in batches, computing 2^p modulo each
+// of them in Montgomery form, for k up to a limit that grows with p such
+// that the time spent stays small compared to the Lucas-Lehmer test. Returns
+// 0 if p is not an odd prime.
+std::uint64_t mersenne_factor(unsigned p);
+
+// Returns the exponents p of the first `count` Mersenne primes 2^p - 1 in
+// increasing order. Up to `num_threads` exponents (0 for
+// default_thread_count) are tested concurrently, each thread grabbing the
+// next candidate as soon as it is done with the previous one.
+std::vector<unsigned> mersenne_prime_exponents(
+    unsigned count, unsigned num_threads = 0);
+
+// Returns the perfect number 2^(p-1) * (2^p - 1) as a string of digits in
+// the given base, which has to be 10 or 16 (lowercase digits, no prefix).
+// Throws a std::runtime_error for any other base.
+std::string perfect_number_string(unsigned p, unsigned base = 10);
+
+// Returns the nth (counting from 1) even perfect number as a string of
+// digits in the given base, see perfect_number_string.
+std::string nth_perfect_number(
+    unsigned n, unsigned base = 10, unsigned num_threads = 0);
@@ -0,0 +1,101 @@
+// This file declares arithmetic modulo an odd 64-bit number in Montgomery
+// form. A number a is represented by a * 2^64 mod n, which turns the
+// division by n needed after each multiplication into two multiplications
+// and a subtraction. The conversions in and out of this form cost about
+// as much as a multiplication, it pays off for long chains of them like the
+// ones in modular exponentiation.
+
+#pragma once
+
+#include <cstdint>
+
+class montgomery
+{
+    using double_word = unsigned __int128;
+
+    std::uint64_t n;
+    std::uint64_t n_inv;    // n^-1 mod 2^64
+    std::uint64_t r1;       // 2^64 mod n, i.e. 1 in Montgomery form
+
+public:
+    // `modulus` has to be odd and larger than 1.
+    explicit montgomery(std::uint64_t modulus)
+      : n(modulus)
+      , n_inv(modulus)    // correct to 3 bits, as n * n == 1 mod 8
+    {
+        // every Newton step doubles the number of correct bits
+        for (int i = 0; i != 5; ++i)
+        {
+            n_inv *= 2 - n * n_inv;
+        }
+        r1 = (0 - n) % n;
+    }
+
+    std::uint64_t modulus() const
+    {
+        return n;
+    }
+
+    // Returns 1 in Montgomery form.
+    std::uint64_t one() const
+    {
+        return r1;
+    }
+
+    // Returns t * 2^-64 mod n for t < n * 2^64.
+    std::uint64_t reduce(double_word t) const
+    {
+        std::uint64_t m = static_cast<std::uint64_t>(t) * n_inv;
+        std::uint64_t mn_high =
+            static_cast<std::uint64_t>((double_word(m) * n) >> 64);
+        std::uint64_t t_high = static_cast<std::uint64_t>(t >> 64);
+        // the low halves of t and m * n are equal, the difference of the
+        // high halves is off by at most n
+        return t_high >= mn_high ? t_high - mn_high : t_high - mn_high + n;
+    }
+
+    // Convert a (less than n) into Montgomery form. This takes a division,
+    // which is why the constructor doesn't prepare 2^128 mod n for it.
+    std::uint64_t to(std::uint64_t a) const
+    {
+        return static_cast<std::uint64_t>((double_word(a) << 64) % n);
+    }
+
+    // Convert a out of Montgomery form.
+    std::uint64_t from(std::uint64_t a) const
+    {
+        return reduce(a);
+    }
+
+    std::uint64_t multiply(std::uint64_t a, std::uint64_t b) const
+    {
+        return reduce(double_word(a) * b);
+    }
+
+    std::uint64_t add(std::uint64_t a, std::uint64_t b) const
+    {
+        // a + b may not fit 64 bits, but a + b - n does if a + b >= n
+        return a >= n - b ? a - (n - b) : a + b;
+    }
+
+    std::uint64_t subtract(std::uint64_t a, std::uint64_t b) const
+    {
+        return a >= b ? a - b : a + (n - b);
+    }
+
+    // Returns a^e, a and the result being in Montgomery form.
+    std::uint64_t power(std::uint64_t a, std::uint64_t e) const
+    {
+        std::uint64_t result = r1;
+        while (e != 0)
+        {
+            if (e & 1)
+            {
+                result = multiply(result, a);
+            }
+            a = multiply(a, a);
+            e >>= 1;
+        }
+        return result;
+    }
+};
@@ -0,0 +1,183 @@
+// This file declares a linear sieve for multiplicative arithmetic functions,
+// functions with f(ab) == f(a) * f(b) for coprime a and b. Such a function
+// is determined by its values on prime powers, which the caller supplies as a
+// rule. The sieve visits every number once, through its smallest prime
+// factor, and fills in the tables of any number of functions on the way, so
+// that several of them cost a single pass.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// A rule describes a multiplicative function f by its value type and
+//
+//     static value_type prime_power(value_type previous, std::uint64_t p,
+//         std::uint64_t power);
+//
+// which returns f(power) for power == p^e given previous == f(p^(e-1)), where
+// f(p^0) == f(1) == 1.
+
+// sigma(n), the sum of the divisors of n.
+struct sigma_rule
+{
+    using value_type = std::uint64_t;
+
+    static value_type prime_power(
+        value_type previous, std::uint64_t, std::uint64_t power)
+    {
+        return previous + power;
+    }
+};
+
+// Euler's phi(n), the number of k in [1, n] coprime to n.
+struct phi_rule
+{
+    using value_type = std::uint32_t;
+
+    static value_type prime_power(
+        value_type previous, std::uint64_t p, std::uint64_t power)
+    {
+        return static_cast<value_type>(power == p ? p - 1 : previous * p);
+    }
+};
+
+// The Moebius function mu(n), 0 if n has a square factor, otherwise -1 or 1
+// for an odd or even number of prime factors.
+struct mu_rule
+{
+    using value_type = std::int8_t;
+
+    static value_type prime_power(
+        value_type, std::uint64_t p, std::uint64_t power)
+    {
+        return power == p ? -1 : 0;
+    }
+};
+
+// d(n), the number of divisors of n. It doesn't exceed 1344 below 2^32.
+struct divisor_count_rule
+{
+    using value_type = std::uint16_t;
+
+    static value_type prime_power(
+        value_type previous, std::uint64_t, std::uint64_t)
+    {
+        return static_cast<value_type>(previous + 1);
+    }
+};
+
+// The tables of the functions given by `Rules` for all n in [0, stop), one
+// array per function. The entries for 0 are 0.
+template <typename... Rules>
+class multiplicative_sieve
+{
+    std::tuple<std::vector<typename Rules::value_type>...> tables;
+
+    // Calls f(table, Rule()) for each rule and its table.
+    template <typename F>
+    void for_each_table(F f)
+    {
+        std::apply([&](auto&... table) { (f(table, Rules()), ...); }, tables);
+    }
+
+    template <typename Rule>
+    static constexpr std::size_t index_of()
+    {
+        constexpr bool matches[] = {std::is_same_v<Rule, Rules>...};
+        std::size_t i = 0;
+        while (!matches[i])
+        {
+            ++i;
+        }
+        return i;
+    }
+
+public:
+    // Throws a std::runtime_error for stop > 2^32, the sieve keeps 32-bit
+    // numbers only to save memory.
+    explicit multiplicative_sieve(std::uint64_t stop)
+    {
+        if (stop > std::uint64_t(std::numeric_limits<std::uint32_t>::max()) + 1)
+        {
+            throw std::runtime_error(
+                "multiplicative_sieve: the range exceeds 32 bits");
+        }
+        for_each_table([&](auto& table, auto) { table.resize(stop); });
+        if (stop < 2)
+        {
+            return;
+        }
+
+        // the power of the smallest prime factor dividing each number, 0 for
+        // the primes that haven't been reached yet
+        std::vector<std::uint32_t> smallest_power(stop, 0);
+        std::vector<std::uint32_t> primes;
+
+        for_each_table([](auto& table, auto) { table[1] = 1; });
+        for (std::uint64_t i = 2; i < stop; ++i)
+        {
+            if (smallest_power[i] == 0)
+            {
+                smallest_power[i] = static_cast<std::uint32_t>(i);
+                primes.push_back(static_cast<std::uint32_t>(i));
+                for_each_table([&](auto& table, auto rule) {
+                    table[i] = rule.prime_power(1, i, i);
+                });
+            }
+            for (std::uint64_t p : primes)
+            {
+                if (p > (stop - 1) / i)
+                {
+                    break;
+                }
+                std::uint64_t const n = i * p;
+                if (i % p != 0)
+                {
+                    smallest_power[n] = static_cast<std::uint32_t>(p);
+                    for_each_table([&](auto& table, auto) {
+                        table[n] = table[i] * table[p];
+                    });
+                    continue;
+                }
+
+                // p is the smallest prime factor of i, and of n
+                std::uint64_t const power = smallest_power[i] * p;
+                smallest_power[n] = static_cast<std::uint32_t>(power);
+                if (power == n)
+                {
+                    for_each_table([&](auto& table, auto rule) {
+                        table[n] = rule.prime_power(table[i], p, n);
+                    });
+                }
+                else
+                {
+                    // the power was reached before, when sieving power / p
+                    for_each_table([&](auto& table, auto) {
+                        table[n] = table[n / power] * table[power];
+                    });
+                }
+                break;    // i * q has the smallest prime factor p, not q
+            }
+        }
+    }
+
+    // Returns the table of the function given by `Rule`, which has to be one
+    // of `Rules`. Moving out of it leaves the table empty.
+    template <typename Rule>
+    std::vector<typename Rule::value_type>& table()
+    {
+        return std::get<index_of<Rule>()>(tables);
+    }
+
+    template <typename Rule>
+    std::vector<typename Rule::value_type> const& table() const
+    {
+        return std::get<index_of<Rule>()>(tables);
+    }
+};
@@ -1,56 +1,125 @@
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <thread>
 
-// The divisor_sum function takes one argument `n` and calculates the sum of
-// proper divisors of `n` excluding itself. To find divisors, a loop iterates
-// over all numbers from 1 to n-1, testing for a zero remainder from the
-// division using the modulus operator %.
-long divisor_sum(long n)
-{
-    long total = 0;
-    for (long divisor = 1; divisor < n; ++divisor)
+#include "divisor_sums.hpp"
+#include "search_channel.hpp"
+
+namespace {
+
+    // The reporter prints the progress this often.
+    constexpr std::chrono::milliseconds report_interval(200);
+
+    // Wide enough to overwrite the progress line.
+    constexpr int line_width = 60;
+
+    // Set on Ctrl-C. A signal handler can't do much more than this safely,
+    // the reporter passes it on to the search.
+    volatile std::sig_atomic_t interrupted = 0;
+
+    void on_interrupt(int)
     {
-        if (n % divisor == 0)
+        interrupted = 1;
+    }
+
+    // Print the perfect numbers that arrived since the last call, then the
+    // progress, which stays on its line until the next call overwrites it.
+    void report(search_channel& channel, std::uint64_t total)
+    {
+        while (auto n = channel.try_pop())
         {
-            total += divisor;
+            std::cout << '\r' << std::left << std::setw(line_width)
+                      << "Found perfect number: " + std::to_string(*n)
+                      << '\n';
         }
+        std::uint64_t searched = channel.searched();
+        std::ostringstream progress;
+        progress << "Searched " << searched << " of " << total << " ("
+                 << (total == 0 ? 100 : 100 * searched / total) << "%)";
+        std::cout << '\r' << std::left << std::setw(line_width)
+                  << progress.str() << std::flush;
     }
-    return total;
-}
+}    // namespace
 
-// The is_perfect function takes one argument `n` and returns a boolean
-// (true/false) value indicating whether or not `n` is perfect. A perfect number
-// is a non-zero positive number whose sum of its proper divisors is equal to
-// itself.
-bool is_perfect(long n)
+// The find_perfect_numbers function takes one argument `stop` and performs an
+// exhaustive search for perfect numbers over the range 1 to `stop` on
+// `num_threads` threads (0 for all cores). The workers never touch the
+// console, a reporter thread prints the perfect numbers they found and the
+// progress every 200 ms. Ctrl-C ends the search early.
+void find_perfect_numbers(std::uint64_t stop, unsigned num_threads)
 {
-    return n != 0 && n == divisor_sum(n);
+    std::uint64_t const total = stop > 1 ? stop - 1 : 0;
+    search_channel channel;
+    std::stop_source cancel;
+    std::signal(SIGINT, on_interrupt);
+
+    perfect_search_result result;
+    {
+        std::jthread reporter([&](std::stop_token done) {
+            std::mutex mutex;
+            std::condition_variable_any wakeup;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!done.stop_requested())
+            {
+                wakeup.wait_for(
+                    lock, done, report_interval, [] { return false; });
+                if (interrupted)
+                {
+                    cancel.request_stop();
+                }
+                report(channel, total);
+            }
+        });
+        result = search_perfect_numbers(
+            1, stop, cancel.get_token(), channel, num_threads);
+    }    // stops the reporter after a last report
+
+    std::uint64_t searched = result.counts.deficient +
+        result.counts.perfect + result.counts.abundant;
+    if (searched == total)
+    {
+        std::cout << "\nDone searching up to " << stop << "\n";
+    }
+    else
+    {
+        std::cout << "\nInterrupted after searching " << searched << " of "
+                  << total << " numbers\n";
+    }
+    std::cout << "Found " << result.perfect_numbers.size()
+              << " perfect numbers.\n";
 }
 
-// The findPerfects function takes one argument `stop` and performs an
-// exhaustive search for perfect numbers over the range 1 to `stop`. Each
-// perfect number found is printed to the console.
-void find_perfect_numbers(long stop)
+// Usage: perfect_numbers [stop [num_threads]]
+int main(int argc, char* argv[])
 {
-    int num_perfect = 0;
-
-    for (long num = 1; num < stop; num++)
+    std::uint64_t stop = 40000;
+    unsigned num_threads = 0;
+    try
     {
-        if (is_perfect(num))
+        if (argc > 1)
         {
-            std::cout << "Found perfect number: " << num << "\n";
-            num_perfect++;
+            stop = std::stoull(argv[1]);
         }
-        if (num % 10000 == 0)
+        if (argc > 2)
         {
-           std::cout << "." << std::flush;    // just for formatting
+            num_threads = static_cast<unsigned>(std::stoul(argv[2]));
         }
     }
-    std::cout << "\nDone searching up to " << stop << "\n";
-    std::cout << "Found " << num_perfect << " perfect numbers.\n";
-}
+    catch (std::exception const&)
+    {
+        std::cerr << "usage: " << argv[0] << " [stop [num_threads]]\n";
+        return 1;
+    }
 
-int main()
-{
-    find_perfect_numbers(40000);
+    find_perfect_numbers(stop, num_threads);
     return 0;
-}
\ No newline at end of file
+}
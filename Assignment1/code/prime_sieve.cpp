@@ -0,0 +1,265 @@
+// This file implements the interface declared in prime_sieve.hpp.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "factorize.hpp"
+#include "prime_sieve.hpp"
+
+namespace {
+
+    // The bytes of a segment. 2^15 bytes are 32 KiB, the size of the L1 data
+    // cache, and cover 983040 numbers.
+    constexpr std::size_t segment_bytes = 1 << 15;
+
+    // Numbers below this are looked up by is_prime in a table of 35 KiB.
+    constexpr std::uint64_t small_prime_limit = 1 << 20;
+
+    // Bit i of the byte for k stands for 30k + residues[i].
+    constexpr std::array<std::uint64_t, 8> residues = {
+        1, 7, 11, 13, 17, 19, 23, 29};
+
+    // The distance from residues[i] to the next residue, 31 for the last.
+    constexpr std::array<std::uint64_t, 8> gaps = {6, 4, 2, 4, 2, 4, 6, 2};
+
+    // The bit standing for a residue modulo 30, or 8 for the residues that
+    // aren't coprime to 30.
+    constexpr std::array<std::uint8_t, 30> bit_of = [] {
+        std::array<std::uint8_t, 30> bits = {};
+        bits.fill(8);
+        for (std::uint8_t i = 0; i != 8; ++i)
+        {
+            bits[residues[i]] = i;
+        }
+        return bits;
+    }();
+
+    // A prime p == 30a + residues[i] crosses off its multiples p * q where q
+    // is coprime to 30. For q == 30k + residues[w] the multiple is p * q ==
+    // residues[i] * residues[w] modulo 30, so it lies at bit
+    // crossing[i][w].bit of its byte. The multiple for the next q is p *
+    // gaps[w] larger, which is a * gaps[w] + crossing[i][w].carry bytes
+    // further.
+    struct crossing_step
+    {
+        std::uint8_t bit;
+        std::uint8_t carry;
+    };
+
+    constexpr std::array<std::array<crossing_step, 8>, 8> crossing = [] {
+        std::array<std::array<crossing_step, 8>, 8> steps = {};
+        for (std::size_t i = 0; i != 8; ++i)
+        {
+            for (std::size_t w = 0; w != 8; ++w)
+            {
+                std::uint64_t low = residues[i] * residues[w] % 30;
+                steps[i][w] = {bit_of[low],
+                    static_cast<std::uint8_t>(
+                        (low + residues[i] * gaps[w]) / 30)};
+            }
+        }
+        return steps;
+    }();
+
+    // A sieving prime and where it continues crossing off.
+    struct sieving_prime
+    {
+        std::uint64_t next_byte;    // absolute, not within the segment
+        std::uint64_t a;            // p / 30
+        std::uint8_t i;             // the bit of p % 30
+        std::uint8_t w;             // the bit of the current q % 30
+    };
+
+    // Sets up p to cross off its multiples p * q, q >= p and q coprime to
+    // 30, from the first one at or above lo on. Returns false if there is
+    // none below hi.
+    bool start_crossing(std::uint64_t p, std::uint64_t lo, std::uint64_t hi,
+        sieving_prime& state)
+    {
+        std::uint64_t q = std::max(p, lo / p + (lo % p != 0));
+        std::uint8_t w = 0;
+        while (residues[w] < q % 30)
+        {
+            ++w;
+        }
+        q += residues[w] - q % 30;
+        if (q > (hi - 1) / p)
+        {
+            return false;
+        }
+        state = {p * q / 30, p / 30, bit_of[p % 30], w};
+        return true;
+    }
+
+    // Calls f(first_byte, bytes) for the segments covering [lo, hi) in
+    // increasing order, where bit j of bytes[k] is set iff 30 * (first_byte +
+    // k) + residues[j] is a prime in [lo, hi). The size of `bytes` is a
+    // multiple of 8, for the caller to read it in 64-bit words, the bytes
+    // past the range are 0. The primes 2, 3 and 5 are left to the caller.
+    template <typename F>
+    void sieve_segments(std::uint64_t lo, std::uint64_t hi, F f)
+    {
+        if (hi <= lo)
+        {
+            return;
+        }
+
+        // the primes from 7 up to sqrt(hi - 1), sieved the same way
+        std::vector<sieving_prime> primes;
+        for (std::uint64_t p : primes_in(7, isqrt(hi - 1) + 1))
+        {
+            sieving_prime state;
+            if (start_crossing(p, lo, hi, state))
+            {
+                primes.push_back(state);
+            }
+        }
+
+        std::vector<std::uint8_t> segment(segment_bytes);
+        std::uint64_t const end_byte = hi / 30 + (hi % 30 != 0);
+        for (std::uint64_t first = lo / 30; first < end_byte;
+             first += segment_bytes)
+        {
+            std::size_t const len =
+                static_cast<std::size_t>(std::min<std::uint64_t>(
+                    segment_bytes, end_byte - first));
+            std::fill_n(segment.begin(), len, 0xff);
+            std::fill(segment.begin() + len, segment.end(), 0);
+
+            std::uint64_t const last = first + len;
+            for (sieving_prime& p : primes)
+            {
+                std::uint64_t next = p.next_byte;
+                std::uint8_t w = p.w;
+                auto const& steps = crossing[p.i];
+                while (next < last)
+                {
+                    segment[next - first] &= ~(1 << steps[w].bit);
+                    next += p.a * gaps[w] + steps[w].carry;
+                    w = (w + 1) & 7;
+                }
+                p.next_byte = next;
+                p.w = w;
+            }
+
+            // the numbers of the outer bytes outside [lo, hi), and 1
+            for (std::uint8_t j = 0; j != 8; ++j)
+            {
+                if (30 * first + residues[j] < lo || (first == 0 && j == 0))
+                {
+                    segment[0] &= ~(1 << j);
+                }
+                if (30 * (last - 1) + residues[j] >= hi)
+                {
+                    segment[len - 1] &= ~(1 << j);
+                }
+            }
+
+            f(first, std::span<std::uint8_t const>(
+                         segment.data(), (len + 7) / 8 * 8));
+        }
+    }
+
+    // Returns the number of primes among 2, 3 and 5 that are in [lo, hi).
+    std::uint64_t count_wheel_primes(std::uint64_t lo, std::uint64_t hi)
+    {
+        std::uint64_t count = 0;
+        for (std::uint64_t p : {2, 3, 5})
+        {
+            count += lo <= p && p < hi;
+        }
+        return count;
+    }
+
+    // Reads 8 bytes of a segment as one word, byte k in bits 8k to 8k + 7.
+    std::uint64_t load_word(std::uint8_t const* bytes)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+}    // namespace
+
+std::vector<std::uint64_t> primes_in(std::uint64_t lo, std::uint64_t hi)
+{
+    std::vector<std::uint64_t> primes;
+    for (std::uint64_t p : {2, 3, 5})
+    {
+        if (lo <= p && p < hi)
+        {
+            primes.push_back(p);
+        }
+    }
+    sieve_segments(lo, hi,
+        [&](std::uint64_t first, std::span<std::uint8_t const> bytes) {
+            for (std::size_t k = 0; k != bytes.size(); k += 8)
+            {
+                std::uint64_t word = load_word(bytes.data() + k);
+                while (word != 0)
+                {
+                    unsigned bit = std::countr_zero(word);
+                    primes.push_back(
+                        30 * (first + k + bit / 8) + residues[bit % 8]);
+                    word &= word - 1;
+                }
+            }
+        });
+    return primes;
+}
+
+std::uint64_t prime_pi(std::uint64_t x)
+{
+    std::uint64_t const hi = x + 1;
+    std::uint64_t count = count_wheel_primes(0, hi);
+    sieve_segments(0, hi,
+        [&](std::uint64_t, std::span<std::uint8_t const> bytes) {
+            for (std::size_t k = 0; k != bytes.size(); k += 8)
+            {
+                count += std::popcount(load_word(bytes.data() + k));
+            }
+        });
+    return count;
+}
+
+bool is_prime(std::uint64_t n)
+{
+    if (n >= small_prime_limit)
+    {
+        return is_prime64(n);
+    }
+    static std::vector<std::uint8_t> const table = [] {
+        std::vector<std::uint8_t> bytes;
+        sieve_segments(0, small_prime_limit,
+            [&](std::uint64_t, std::span<std::uint8_t const> segment) {
+                bytes.insert(bytes.end(), segment.begin(), segment.end());
+            });
+        return bytes;
+    }();
+    std::uint8_t const bit = bit_of[n % 30];
+    if (bit == 8)
+    {
+        return n == 2 || n == 3 || n == 5;
+    }
+    return (table[n / 30] >> bit) & 1;
+}
+
+std::uint64_t isqrt(std::uint64_t n)
+{
+    auto root = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(n)));
+    while (root > 0 && root > n / root)
+    {
+        --root;
+    }
+    while (root + 1 <= n / (root + 1))
+    {
+        ++root;
+    }
+    return root;
+}
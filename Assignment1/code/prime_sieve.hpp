@@ -0,0 +1,25 @@
+// This file declares the prime sieve shared by the arithmetic routines. It is
+// a segmented sieve of Eratosthenes on the wheel of 30: only the 8 residues
+// modulo 30 coprime to 2, 3 and 5 are stored, one bit each, so that a byte
+// covers 30 numbers. A segment of 32 KiB thus covers almost a million
+// numbers and stays in the L1 cache while every sieving prime crosses off
+// its multiples in it.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Returns the primes p with lo <= p < hi in increasing order.
+std::vector<std::uint64_t> primes_in(std::uint64_t lo, std::uint64_t hi);
+
+// Returns the number of primes up to and including x. The primes are counted
+// segment by segment, without being stored.
+std::uint64_t prime_pi(std::uint64_t x);
+
+// Returns whether n is prime. Numbers below 2^20 are looked up in a table
+// built by the sieve on first use, larger ones are given to is_prime64.
+bool is_prime(std::uint64_t n);
+
+// Returns floor(sqrt(n)), correcting the rounding of the double square root.
+std::uint64_t isqrt(std::uint64_t n);
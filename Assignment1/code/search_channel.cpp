@@ -0,0 +1,91 @@
+// This file implements the interface declared in search_channel.hpp.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "search_channel.hpp"
+
+search_channel::search_channel()
+{
+    for (std::size_t i = 0; i != capacity; ++i)
+    {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool search_channel::try_push(std::uint64_t n)
+{
+    std::uint64_t pos = push_position.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell& c = cells[pos % capacity];
+        std::uint64_t sequence = c.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::int64_t>(sequence - pos);
+        if (difference < 0)
+        {
+            return false;    // the cell still holds the value from a lap ago
+        }
+        if (difference == 0 &&
+            push_position.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed))
+        {
+            c.value = n;
+            c.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+        if (difference > 0)
+        {
+            // another thread took the position
+            pos = push_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+std::optional<std::uint64_t> search_channel::try_pop()
+{
+    std::uint64_t pos = pop_position.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell& c = cells[pos % capacity];
+        std::uint64_t sequence = c.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::int64_t>(sequence - (pos + 1));
+        if (difference < 0)
+        {
+            return std::nullopt;    // the cell hasn't been filled yet
+        }
+        if (difference == 0 &&
+            pop_position.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed))
+        {
+            std::uint64_t n = c.value;
+            c.sequence.store(pos + capacity, std::memory_order_release);
+            return n;
+        }
+        if (difference > 0)
+        {
+            pos = pop_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void search_channel::add_counts(number_kind_counts const& counts)
+{
+    deficient.fetch_add(counts.deficient, std::memory_order_relaxed);
+    perfect.fetch_add(counts.perfect, std::memory_order_relaxed);
+    abundant.fetch_add(counts.abundant, std::memory_order_relaxed);
+}
+
+number_kind_counts search_channel::counts() const
+{
+    return {deficient.load(std::memory_order_relaxed),
+        perfect.load(std::memory_order_relaxed),
+        abundant.load(std::memory_order_relaxed)};
+}
+
+std::uint64_t search_channel::searched() const
+{
+    number_kind_counts c = counts();
+    return c.deficient + c.perfect + c.abundant;
+}
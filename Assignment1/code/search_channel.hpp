@@ -0,0 +1,64 @@
+// This file declares the channel through which a running perfect number
+// search reports its progress. The worker threads publish into it without
+// ever taking a lock or waiting, any other thread reads from it at its own
+// pace, so a slow terminal cannot hold up the search.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "divisor_sums.hpp"
+
+class search_channel
+{
+public:
+    // The number of found numbers the channel holds until they are taken.
+    static constexpr std::size_t capacity = 64;
+
+private:
+    // A bounded queue after Dmitry Vyukov: a cell is free for the push at
+    // position pos when its sequence is pos, and holds the value for the
+    // pop at pos when it is pos + 1. Taking the value frees the cell for
+    // position pos + capacity.
+    struct cell
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t value;
+    };
+    std::array<cell, capacity> cells;
+
+    // the positions and counters are written by different threads, keep
+    // them on separate cache lines
+    alignas(64) std::atomic<std::uint64_t> push_position = 0;
+    alignas(64) std::atomic<std::uint64_t> pop_position = 0;
+    alignas(64) std::atomic<std::uint64_t> deficient = 0;
+    std::atomic<std::uint64_t> perfect = 0;
+    std::atomic<std::uint64_t> abundant = 0;
+
+public:
+    search_channel();
+
+    search_channel(search_channel const&) = delete;
+    search_channel& operator=(search_channel const&) = delete;
+
+    // Add a found number, returns false without waiting if the channel is
+    // full.
+    bool try_push(std::uint64_t n);
+
+    // Take the oldest number, or nothing if the channel is empty.
+    std::optional<std::uint64_t> try_pop();
+
+    // Add the counts of a searched part of the range.
+    void add_counts(number_kind_counts const& counts);
+
+    // Return the counts of the numbers searched so far. The three counts are
+    // read one after the other, not as one snapshot.
+    number_kind_counts counts() const;
+
+    // Return the number of numbers searched so far.
+    std::uint64_t searched() const;
+};
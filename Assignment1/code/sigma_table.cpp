@@ -0,0 +1,208 @@
+// This file implements the interface declared in sigma_table.hpp.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include "divisor_sums.hpp"
+#include "mapped_file.hpp"
+#include "sigma_table.hpp"
+
+namespace {
+
+    constexpr char magic[8] = {'S', 'I', 'G', 'M', 'A', 'T', 'A', 'B'};
+    constexpr std::uint32_t version = 1;
+
+    struct header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entry_size;
+        std::uint64_t stop;
+        std::uint64_t checksum;
+        std::uint64_t reserved[4];
+    };
+    static_assert(sizeof(header) == 64);
+
+    constexpr std::uint64_t fnv_offset_basis = 0xcbf29ce484222325;
+    constexpr std::uint64_t fnv_prime = 0x100000001b3;
+
+    // Continue the FNV-1a hash `hash` over the given bytes.
+    std::uint64_t fnv1a(std::uint64_t hash, std::span<std::byte const> bytes)
+    {
+        for (std::byte b : bytes)
+        {
+            hash = (hash ^ static_cast<std::uint64_t>(b)) * fnv_prime;
+        }
+        return hash;
+    }
+
+    std::size_t file_size(std::uint64_t stop)
+    {
+        return sizeof(header) + stop * sizeof(std::uint64_t);
+    }
+
+    // Returns whether the header of `file` has yet to be written, as in a
+    // file that was just created, or whose creation was interrupted.
+    bool lacks_header(mapped_file const& file)
+    {
+        std::span<std::byte const> bytes = file.bytes();
+        return bytes.size() < sizeof(header) ||
+            std::all_of(bytes.begin(), bytes.begin() + sizeof(header),
+                [](std::byte b) { return b == std::byte(0); });
+    }
+
+    // An exclusive flock on the file at `path`, which is created if it
+    // doesn't exist, held for the lifetime of this object.
+    class file_lock
+    {
+        int fd;
+
+    public:
+        explicit file_lock(std::string const& path)
+          : fd(::open(path.c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0644))
+        {
+            if (fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(),
+                    "sigma_table: cannot open " + path);
+            }
+            if (::flock(fd, LOCK_EX) != 0)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(),
+                    "sigma_table: cannot lock " + path);
+            }
+        }
+
+        file_lock(file_lock const&) = delete;
+        file_lock& operator=(file_lock const&) = delete;
+
+        ~file_lock()
+        {
+            ::close(fd);    // releases the lock
+        }
+    };
+
+    // Returns the header of the table in `file`, checking that it is one.
+    header read_header(mapped_file const& file, std::string const& path)
+    {
+        header h;
+        if (file.size() < sizeof(header))
+        {
+            throw std::runtime_error(
+                "sigma_table: " + path + " is not a sigma table");
+        }
+        std::memcpy(&h, file.bytes().data(), sizeof(header));
+        if (std::memcmp(h.magic, magic, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error(
+                "sigma_table: " + path + " is not a sigma table");
+        }
+        if (h.version != version || h.entry_size != sizeof(std::uint64_t))
+        {
+            throw std::runtime_error("sigma_table: " + path +
+                " has an unsupported version " + std::to_string(h.version));
+        }
+        // an interrupted extension leaves entries behind the ones counted
+        if (file.size() < file_size(h.stop))
+        {
+            throw std::runtime_error(
+                "sigma_table: " + path + " is truncated");
+        }
+        return h;
+    }
+}    // namespace
+
+sigma_table::sigma_table(
+    std::string const& path, std::uint64_t stop, unsigned num_threads)
+  : file(std::filesystem::exists(path)
+            ? mapped_file(path, mapped_file::access::read_only)
+            : mapped_file(path, mapped_file::access::read_write))
+{
+    if (!lacks_header(file) && read_header(file, path).stop >= stop)
+    {
+        load(path);
+        return;
+    }
+
+    // Another process may have extended the table while this one waited
+    // for the lock, so the header is read again.
+    file_lock const lock(path);
+    file = mapped_file(path, mapped_file::access::read_write);
+    header h = {};
+    if (lacks_header(file))
+    {
+        // a new table starts out empty, with its header written before any
+        // entry
+        std::memcpy(h.magic, magic, sizeof(magic));
+        h.version = version;
+        h.entry_size = sizeof(std::uint64_t);
+        h.checksum = fnv_offset_basis;
+        file.resize(sizeof(header));
+        std::memcpy(file.mutable_bytes().data(), &h, sizeof(header));
+        file.flush();
+    }
+    else
+    {
+        h = read_header(file, path);
+    }
+    if (h.stop >= stop)
+    {
+        file = mapped_file(path, mapped_file::access::read_only);
+        load(path);
+        return;
+    }
+
+    // Write the new entries first and the header last, so that the file
+    // keeps the entries it had if this is interrupted.
+    file.resize(file_size(stop));
+    std::span<std::byte> bytes = file.mutable_bytes();
+    std::span<std::byte> appended = bytes.subspan(file_size(h.stop));
+    sigma_range(h.stop,
+        {reinterpret_cast<std::uint64_t*>(appended.data()), stop - h.stop},
+        num_threads);
+    file.flush();
+
+    h.stop = stop;
+    h.checksum = fnv1a(h.checksum, appended);
+    std::memcpy(bytes.data(), &h, sizeof(header));
+    file.flush();
+
+    file = mapped_file(path, mapped_file::access::read_only);
+    load(path);
+}
+
+sigma_table::sigma_table(std::string const& path)
+  : file(path, mapped_file::access::read_only)
+{
+    load(path);
+}
+
+void sigma_table::load(std::string const& path)
+{
+    header h = read_header(file, path);
+    stop = h.stop;
+    checksum = h.checksum;
+    entries = reinterpret_cast<std::uint64_t const*>(
+        file.bytes().data() + sizeof(header));
+}
+
+bool sigma_table::verify() const
+{
+    std::span<std::byte const> bytes =
+        file.bytes().subspan(sizeof(header), stop * sizeof(std::uint64_t));
+    return fnv1a(fnv_offset_basis, bytes) == checksum;
+}
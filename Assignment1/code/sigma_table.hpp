@@ -0,0 +1,81 @@
+// This file declares a table of sigma(n) that is kept in a file, so that it
+// is computed once and every later run just maps it into memory. The file
+// starts with a 64-byte header, followed by sigma(n) for all n in [0, stop)
+// as 64-bit numbers, all in the byte order of the machine:
+//
+//     offset  size  contents
+//          0     8  "SIGMATAB"
+//          8     4  the version of the format, 1
+//         12     4  the size of an entry, 8
+//         16     8  stop
+//         24     8  the 64-bit FNV-1a hash of the entries
+//         32    32  reserved, 0
+//
+// As the hash is computed byte by byte, extending the table only needs to
+// hash the new entries.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "divisor_sums.hpp"
+#include "mapped_file.hpp"
+
+class sigma_table
+{
+    mapped_file file;
+    std::uint64_t const* entries = nullptr;
+    std::uint64_t stop = 0;
+    std::uint64_t checksum = 0;
+
+    void load(std::string const& path);
+
+public:
+    // Open the table in the file at `path` and extend it to cover at least
+    // [0, stop), creating the file if it doesn't exist. Missing entries are
+    // sieved using up to `num_threads` threads (0 for default_thread_count)
+    // and appended. A table that covers the range already is mapped
+    // read-only without computing anything. The extension holds an
+    // exclusive flock on the file, a second process extending it at the
+    // same time waits and then finds the entries appended by the first. If
+    // the extension is interrupted, the file keeps the entries it had.
+    // Throws a std::runtime_error if the file is not a table of this
+    // version, or a std::system_error if it cannot be accessed.
+    sigma_table(
+        std::string const& path, std::uint64_t stop, unsigned num_threads = 0);
+
+    // Open the existing table in the file at `path` as it is.
+    explicit sigma_table(std::string const& path);
+
+    // Return the end of the range [0, size()) the table covers.
+    std::uint64_t size() const
+    {
+        return stop;
+    }
+
+    std::uint64_t sigma(std::uint64_t n) const
+    {
+        return entries[n];
+    }
+
+    std::uint64_t proper_divisor_sum(std::uint64_t n) const
+    {
+        return entries[n] - n;
+    }
+
+    number_kind kind(std::uint64_t n) const
+    {
+        return classify(n, proper_divisor_sum(n));
+    }
+
+    std::span<std::uint64_t const> sigmas() const
+    {
+        return {entries, stop};
+    }
+
+    // Hash all entries and compare the result with the hash in the header,
+    // which detects a file that was damaged after it was written.
+    bool verify() const;
+};
@@ -1,12 +1,28 @@
 
+#include <algorithm>
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "catch.hpp"
 
+#include "soundex_batch.hpp"
+#include "soundex_code.hpp"
+#include "soundex_index.hpp"
+#include "soundex_scan.hpp"
+#include "surname_file.hpp"
+
 // converts char to std::string
 std::string char_to_string(char c)
 {
@@ -147,8 +163,8 @@ STUDENT_TEST("Test more truncate_or_pad")
     CHECK(truncate_or_pad("123456") == "1234");
 }
 
-// Calculate the Soundex code for the given name `s`
-std::string soundex(std::string const& s)
+// Calculate the Soundex code for the given name `s` step by step
+std::string soundex_by_steps(std::string const& s)
 {
     if (s.empty())
     {
@@ -169,6 +185,13 @@ std::string soundex(std::string const& s)
     return truncate_or_pad(no_zeros);
 }
 
+// Calculate the Soundex code for the given name `s` in a single pass, see
+// soundex_code.hpp
+std::string soundex(std::string const& s)
+{
+    return soundex_string(soundex_packed(s));
+}
+
 PROVIDED_TEST("Test soundex")
 {
     CHECK(soundex("") == "");
@@ -181,6 +204,24 @@ STUDENT_TEST("Test more soundex")
     CHECK(soundex("Oest") == "O230");
 }
 
+STUDENT_TEST("Test soundex_packed")
+{
+    // the quirks of the steps carry over: the first character is kept even
+    // if it is not a letter, unless it is '0'
+    for (std::string name : {"", "a", "Tymczak", "Pfister", "Lloyd", "'Oest",
+             "O'Hara", "-x-", "0abc", "0a", "Ashcraft", "aeiou",
+             "Rubin-Rubin", "van der Berg"})
+    {
+        CHECK(soundex(name) == soundex_by_steps(name));
+    }
+    CHECK(soundex("Tymczak") == "T522");
+    CHECK(soundex("0abc") == "1200");
+    CHECK(soundex("123") == "0000");
+    CHECK(soundex("'Oest") == "'230");
+    CHECK(soundex_packed("Ellery") == soundex_packed("Euler"));
+    CHECK(soundex_packed("") == empty_soundex);
+}
+
 // Read a list of names from the given file, one name per line. The function
 // returns a std::vector containing the read names, one name per element.
 std::vector<std::string> read_surnames_from_file(
@@ -201,6 +242,97 @@ std::vector<std::string> read_surnames_from_file(
     return result;
 }
 
+STUDENT_TEST("Test soundex on all surnames")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    REQUIRE(names.size() == 88799);
+    for (std::string const& name : names)
+    {
+        CHECK(soundex(name) == soundex_by_steps(name));
+    }
+}
+
+STUDENT_TEST("Single BENCHMARK of soundex")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    BENCHMARK("soundex_by_steps() of all surnames")
+    {
+        std::size_t length = 0;
+        for (std::string const& name : names)
+        {
+            length += soundex_by_steps(name).size();
+        }
+        return length;
+    };
+    BENCHMARK("soundex_packed() of all surnames")
+    {
+        packed_soundex sum = 0;
+        for (std::string const& name : names)
+        {
+            sum += soundex_packed(name);
+        }
+        return sum;
+    };
+}
+
+STUDENT_TEST("Test soundex_batch")
+{
+    // a block takes 16 names, the rest are encoded one by one
+    std::vector<std::string> names = {"", "a", "Tymczak", "Pfister",
+        "Lloyd", "'Oest", "O'Hara", "-x-", "0abc", "0a", "Ashcraft", "aeiou",
+        "Rubin-Rubin", "van der Berg", "123", "zzz", "Quetzalcoatl",
+        "Wolfeschlegelsteinhausenbergerdorff", "abcdefghijklmnopqrstuvwxyz",
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "\xe9mile", "[`{@]"};
+    for (int c = 0; c != 256; ++c)
+    {
+        names.push_back(std::string(1, static_cast<char>(c)) + "ob");
+        names.push_back("b" + std::string(1, static_cast<char>(c)) + "p");
+    }
+    std::vector<packed_soundex> codes(names.size());
+    soundex_batch(names, codes);
+    for (std::size_t i = 0; i != names.size(); ++i)
+    {
+        CHECK(codes[i] == soundex_packed(names[i]));
+    }
+    CHECK_THROWS(soundex_batch(names, std::span(codes).first(3)));
+
+    // views without data in a block
+    std::vector<std::string_view> views(names.begin(), names.begin() + 20);
+    views[3] = views[17] = std::string_view();
+    soundex_batch(views, std::span(codes).first(views.size()));
+    for (std::size_t i = 0; i != views.size(); ++i)
+    {
+        CHECK(codes[i] == soundex_packed(views[i]));
+    }
+
+    surname_file const file(SURNAMES_FILE);
+    codes.resize(file.size());
+    soundex_batch(file.names(), codes);
+    for (std::size_t i = 0; i != file.size(); ++i)
+    {
+        CHECK(codes[i] == soundex_packed(file[i]));
+    }
+}
+
+STUDENT_TEST("Single BENCHMARK of soundex_batch")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    std::vector<packed_soundex> codes(names.size());
+    BENCHMARK("soundex_packed() of all surnames into a vector")
+    {
+        for (std::size_t i = 0; i != names.size(); ++i)
+        {
+            codes[i] = soundex_packed(names[i]);
+        }
+        return codes.back();
+    };
+    BENCHMARK("soundex_batch() of all surnames")
+    {
+        soundex_batch(names, codes);
+        return codes.back();
+    };
+}
+
 std::vector<std::string> soundex_search(
     std::vector<std::string> const& names,    // list of all names
     std::string const& soundex_code)          // soundex code to find
@@ -222,6 +354,210 @@ std::vector<std::string> soundex_search(
     return matches;
 }
 
+// Like soundex_search above, but looking the code up in an index of the
+// names built beforehand, instead of encoding all of them again.
+std::vector<std::string> soundex_search(
+    std::vector<std::string> const& names,    // list of all names
+    soundex_index const& index,               // index of `names`
+    packed_soundex code)                      // soundex code to find
+{
+    std::vector<std::string> matches;
+    for (std::uint32_t id : index.find(code))
+    {
+        matches.push_back(names[id]);
+    }
+    return matches;
+}
+
+// Like soundex_search above, but encoding the names in parallel with
+// soundex_scan, for a one-off search that isn't worth building an index for.
+std::vector<std::string> parallel_soundex_search(
+    std::vector<std::string> const& names,    // list of all names
+    packed_soundex code,                      // soundex code to find
+    unsigned num_threads = 0)
+{
+    std::vector<std::string> matches;
+    for (std::uint32_t id : soundex_scan(names, code, num_threads))
+    {
+        matches.push_back(names[id]);
+    }
+    return matches;
+}
+
+STUDENT_TEST("Test soundex_index")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    soundex_index index(names);
+    REQUIRE(index.size() == names.size());
+
+    for (std::string name : {"Oest", "Elenski", "Angelou", "Smith", "Lee",
+             "Zyskowski", "Qxqx"})
+    {
+        std::string code = soundex(name);
+        CHECK(soundex_search(names, index, soundex_packed(name)) ==
+            soundex_search(names, code));
+    }
+    CHECK(index.find(soundex_packed("Smith")).size() == 115);
+    CHECK(index.find(empty_soundex).empty());
+    CHECK(index.find(packed_soundex_count).empty());
+    CHECK(index.find(~packed_soundex(0)).empty());
+
+    // every name is in the run of its code
+    std::vector<int> seen(names.size(), 0);
+    for (std::size_t i = 0; i != names.size(); ++i)
+    {
+        for (std::uint32_t id : index.find(soundex_packed(names[i])))
+        {
+            seen[id] += id == i;
+        }
+    }
+    CHECK(std::count(seen.begin(), seen.end(), 1) == long(names.size()));
+
+    CHECK(soundex_index(std::vector<std::string>()).size() == 0);
+}
+
+STUDENT_TEST("Single BENCHMARK of soundex_search")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    BENCHMARK("soundex_search() of Smith")
+    {
+        return soundex_search(names, "S530").size();
+    };
+    BENCHMARK("Build the soundex index")
+    {
+        return soundex_index(names).size();
+    };
+    soundex_index index(names);
+    BENCHMARK("Look up Smith in the index")
+    {
+        return index.find(soundex_packed("Smith")).size();
+    };
+    BENCHMARK("soundex_search() of Smith with the index")
+    {
+        return soundex_search(names, index, soundex_packed("Smith")).size();
+    };
+}
+
+// Like soundex_search above, for names loaded with surname_file.
+std::vector<std::string_view> soundex_search(
+    surname_file const& names,    // list of all names
+    soundex_index const& index,   // index of `names`
+    packed_soundex code)          // soundex code to find
+{
+    std::vector<std::string_view> matches;
+    for (std::uint32_t id : index.find(code))
+    {
+        matches.push_back(names[id]);
+    }
+    return matches;
+}
+
+STUDENT_TEST("Test surname_file")
+{
+    std::vector<std::string> read = read_surnames_from_file(SURNAMES_FILE);
+    surname_file const mapped(SURNAMES_FILE);
+    REQUIRE(mapped.size() == read.size());
+    CHECK(std::equal(read.begin(), read.end(), mapped.names().begin()));
+
+    soundex_index index(mapped.names());
+    CHECK(soundex_search(mapped, index, soundex_packed("Smith")).size() ==
+        115);
+
+    // lines longer than a block, blank lines, CRLF and no final newline
+    std::filesystem::path const path =
+        std::filesystem::temp_directory_path() / "surname_file_test.txt";
+    struct remove_on_exit    // however the test ends
+    {
+        std::filesystem::path path;
+        ~remove_on_exit()
+        {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+    } const cleanup{path};
+
+    std::string long_name(100, 'x');
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "Abel\r\n\n" << long_name << "\nBaker\n\n\r\nCole";
+    }
+    surname_file lines(path.string());
+    CHECK(std::vector<std::string_view>(
+              lines.names().begin(), lines.names().end()) ==
+        std::vector<std::string_view>{"Abel", long_name, "Baker", "Cole"});
+
+    // the views survive moving the file
+    surname_file moved(std::move(lines));
+    CHECK(moved[3] == "Cole");
+    std::filesystem::remove(path);
+
+    CHECK_THROWS_AS(surname_file(path.string()), std::system_error);
+}
+
+STUDENT_TEST("Test parallel_soundex_search")
+{
+    std::vector<std::string> names = read_surnames_from_file(SURNAMES_FILE);
+    for (std::string name : {"Oest", "Smith", "Lee", "Qxqx"})
+    {
+        std::vector<std::string> expected =
+            soundex_search(names, soundex(name));
+        CHECK(parallel_soundex_search(names, soundex_packed(name)) ==
+            expected);
+        CHECK(parallel_soundex_search(names, soundex_packed(name), 2) ==
+            expected);
+    }
+
+    // 2 million names, enough for 7 threads
+    surname_file const file(SURNAMES_FILE);
+    std::vector<std::string_view> many;
+    for (int i = 0; i != 23; ++i)
+    {
+        many.insert(many.end(), file.names().begin(), file.names().end());
+    }
+    soundex_index const index(many);
+    packed_soundex const smith = soundex_packed("Smith");
+    std::span<std::uint32_t const> expected = index.find(smith);
+    for (unsigned num_threads : {1, 3, 7})
+    {
+        std::vector<std::uint32_t> ids =
+            soundex_scan(many, smith, num_threads);
+        CHECK(std::equal(ids.begin(), ids.end(), expected.begin(),
+            expected.end()));
+    }
+    CHECK(soundex_scan(std::vector<std::string>(), smith).empty());
+}
+
+STUDENT_TEST("Single BENCHMARK of parallel_soundex_search")
+{
+    surname_file const file(SURNAMES_FILE);
+    std::vector<std::string_view> many;
+    for (int i = 0; i != 23; ++i)
+    {
+        many.insert(many.end(), file.names().begin(), file.names().end());
+    }
+    packed_soundex const smith = soundex_packed("Smith");
+    BENCHMARK("Scan 2 million names on one thread")
+    {
+        return soundex_scan(many, smith, 1).size();
+    };
+    BENCHMARK("Scan 2 million names on all cores")
+    {
+        return soundex_scan(many, smith).size();
+    };
+}
+
+STUDENT_TEST("Single BENCHMARK of loading the surnames")
+{
+    BENCHMARK("read_surnames_from_file()")
+    {
+        return read_surnames_from_file(SURNAMES_FILE).size();
+    };
+    BENCHMARK("surname_file")
+    {
+        return surname_file(SURNAMES_FILE).size();
+    };
+}
+
 int main(int argc, char* argv[])
 {
     // first run all tests (you may comment that out once all tests pass)
@@ -230,10 +566,11 @@ int main(int argc, char* argv[])
     /*
     // read file with names
     std::string filepath("../data/us_surnames.txt");
-    std::vector<std::string> names = read_surnames_from_file(filepath);
+    surname_file const names(filepath);
 
     std::cout << "Read file " << filepath << ", " << names.size()
               << " names found.\n\n";
+    soundex_index const index(names.names());
 
     while (true)
     {
@@ -248,12 +585,14 @@ int main(int argc, char* argv[])
         }
 
         // calculate soundex code for the name read
-        std::string soundex_code = soundex(name);
-        std::cout << "Soundex code is " << soundex_code << '\n';
-
-        // go through database and find all names that have the same
-        // soundex code
-        std::vector<std::string> matches = soundex_search(names, soundex_code);
+        packed_soundex soundex_code = soundex_packed(name);
+        std::cout << "Soundex code is " << soundex_string(soundex_code)
+                  << '\n';
+
+        // look up all names in the database that have the same soundex
+        // code
+        std::vector<std::string_view> matches =
+            soundex_search(names, index, soundex_code);
         std::cout << "Matches from database: ";
         if (matches.empty())
         {
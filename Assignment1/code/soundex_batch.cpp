@@ -0,0 +1,265 @@
+// This file implements the interface declared in soundex_batch.hpp.
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <tmmintrin.h>
+#endif
+
+#include "soundex_batch.hpp"
+#include "soundex_code.hpp"
+
+namespace {
+
+    // The number of names encoded together, one per byte of a register.
+    constexpr std::size_t lanes = 16;
+
+#if defined(__SSE2__)
+    // The longest name encoded in a block, two columns of 16 x 16 bytes.
+    constexpr std::size_t max_block_length = 32;
+
+    // Copies the n <= 16 bytes at `from` to `to`. The copies of a fixed
+    // size, which overlap unless n is a power of two, are inlined unlike a
+    // call to memcpy.
+    void copy_short(unsigned char* to, char const* from, std::size_t n)
+    {
+        if (n >= 8)
+        {
+            std::memcpy(to, from, 8);
+            std::memcpy(to + n - 8, from + n - 8, 8);
+        }
+        else if (n >= 4)
+        {
+            std::memcpy(to, from, 4);
+            std::memcpy(to + n - 4, from + n - 4, 4);
+        }
+        else
+        {
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                to[i] = static_cast<unsigned char>(from[i]);
+            }
+        }
+    }
+
+    // Transposes the 16 x 16 bytes in `rows`. Interleaving the first half
+    // of the rows with the second half four times over moves every byte
+    // to its transposed place.
+    __attribute__((target("ssse3"))) void transpose(__m128i (&rows)[lanes])
+    {
+        for (int stage = 0; stage != 4; ++stage)
+        {
+            __m128i interleaved[lanes];
+            for (std::size_t i = 0; i != lanes / 2; ++i)
+            {
+                interleaved[2 * i] =
+                    _mm_unpacklo_epi8(rows[i], rows[i + lanes / 2]);
+                interleaved[2 * i + 1] =
+                    _mm_unpackhi_epi8(rows[i], rows[i + lanes / 2]);
+            }
+            std::copy(interleaved, interleaved + lanes, rows);
+        }
+    }
+
+    // Returns the n <= 16 bytes at `from` followed by zeros. Reading the
+    // 16 bytes at once is safe as long as they don't cross into the next
+    // page, which might not be mapped, and spares copying them through
+    // memory, which stalls the load until the copies are stored.
+    __attribute__((target("ssse3"), no_sanitize_address)) __m128i load_short(
+        char const* from, std::size_t n)
+    {
+        constexpr std::uintptr_t page_size = 4096;
+        if ((reinterpret_cast<std::uintptr_t>(from) & (page_size - 1)) >
+            page_size - 16)
+        {
+            alignas(16) unsigned char bytes[16] = {};
+            copy_short(bytes, from, n);
+            return _mm_load_si128(reinterpret_cast<__m128i const*>(bytes));
+        }
+        __m128i const index =
+            _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m128i const in_name =
+            _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(n)), index);
+        return _mm_and_si128(in_name,
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(from)));
+    }
+
+    // Stores the codes of 16 names in `codes`.
+    __attribute__((target("ssse3"))) void encode_block(
+        std::string_view const (&names)[lanes], packed_soundex* codes)
+    {
+        // the lanes of the names left to soundex_packed stay all zeros,
+        // which aren't letters
+        unsigned left_out = 0;    // a bit per lane
+        std::size_t length = 0;
+        __m128i rows[2][lanes];
+        for (std::size_t i = 0; i != lanes; ++i)
+        {
+            std::string_view const name = names[i];
+            bool const in_block = !name.empty() && name.front() != '0' &&
+                name.size() <= max_block_length;
+            left_out |= unsigned(!in_block) << i;
+            rows[0][i] = rows[1][i] = _mm_setzero_si128();
+            if (in_block)
+            {
+                std::size_t const n = name.size();
+                rows[0][i] = load_short(name.data(), std::min(n, lanes));
+                if (n > lanes)
+                {
+                    rows[1][i] = load_short(name.data() + lanes, n - lanes);
+                }
+                length = std::max(length, n);
+            }
+        }
+
+        // the digits of 'A' to 'P' and of 'Q' to 'Z'
+        __m128i const digits_a_to_p =
+            _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 0, 0, 2, 2, 4, 5, 5, 0, 1);
+        __m128i const digits_q_to_z =
+            _mm_setr_epi8(2, 6, 2, 3, 0, 1, 0, 2, 0, 2, 0, 0, 0, 0, 0, 0);
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const three = _mm_set1_epi8(3);
+
+        __m128i first = zero;      // the first character, in uppercase
+        __m128i seen = zero;       // all ones after the first letter
+        __m128i previous = zero;   // the digit of the last letter
+        __m128i count = zero;      // the number of digits kept
+        __m128i digits[3] = {zero, zero, zero};
+        for (std::size_t start = 0; start < length; start += lanes)
+        {
+            __m128i (&columns)[lanes] = rows[start / lanes];
+            transpose(columns);
+            if (start == 0)
+            {
+                __m128i const lower = _mm_sub_epi8(columns[0],
+                    _mm_set1_epi8('a'));
+                __m128i const is_lower = _mm_cmpeq_epi8(
+                    _mm_min_epu8(lower, _mm_set1_epi8(25)), lower);
+                first = _mm_sub_epi8(columns[0],
+                    _mm_and_si128(is_lower, _mm_set1_epi8(0x20)));
+            }
+
+            std::size_t const end = std::min(length - start, lanes);
+            for (std::size_t c = 0; c != end; ++c)
+            {
+                // clearing bit 5 maps the lowercase letters to uppercase,
+                // then the letters are the bytes 0 to 25 past 'A'
+                __m128i const letter = _mm_sub_epi8(
+                    _mm_and_si128(columns[c], _mm_set1_epi8(~0x20)),
+                    _mm_set1_epi8('A'));
+                __m128i const is_letter = _mm_cmpeq_epi8(
+                    _mm_min_epu8(letter, _mm_set1_epi8(25)), letter);
+
+                // a shuffle yields 0 where bit 7 of the index is set, which
+                // the saturating add does for 'Q' and up and the subtraction
+                // for 'P' and down
+                __m128i const digit = _mm_or_si128(
+                    _mm_shuffle_epi8(digits_a_to_p,
+                        _mm_adds_epu8(letter, _mm_set1_epi8(0x70))),
+                    _mm_shuffle_epi8(digits_q_to_z,
+                        _mm_sub_epi8(letter, _mm_set1_epi8(16))));
+
+                // the first letter only sets the digit to coalesce with
+                __m128i keep = _mm_and_si128(is_letter, seen);
+                keep = _mm_andnot_si128(_mm_cmpeq_epi8(digit, previous), keep);
+                keep = _mm_andnot_si128(_mm_cmpeq_epi8(digit, zero), keep);
+                keep = _mm_andnot_si128(_mm_cmpeq_epi8(count, three), keep);
+                for (int d = 0; d != 3; ++d)
+                {
+                    __m128i const slot = _mm_set1_epi8(static_cast<char>(d));
+                    __m128i const here =
+                        _mm_and_si128(keep, _mm_cmpeq_epi8(count, slot));
+                    digits[d] = _mm_or_si128(
+                        _mm_andnot_si128(here, digits[d]),
+                        _mm_and_si128(here, digit));
+                }
+                count = _mm_sub_epi8(count, keep);    // keep is 0 or -1
+                previous = _mm_or_si128(
+                    _mm_andnot_si128(is_letter, previous),
+                    _mm_and_si128(is_letter, digit));
+                seen = _mm_or_si128(seen, is_letter);
+            }
+        }
+
+        // a name without letters gets "0000", its digits are zeros already
+        first = _mm_or_si128(_mm_and_si128(seen, first),
+            _mm_andnot_si128(seen, _mm_set1_epi8('0')));
+
+        // widen the lanes to 16 and then to 32 bits to put the code
+        // together
+        for (int half = 0; half != 2; ++half)
+        {
+            auto widen = [half, zero](__m128i bytes) {
+                return half == 0 ? _mm_unpacklo_epi8(bytes, zero)
+                                 : _mm_unpackhi_epi8(bytes, zero);
+            };
+            __m128i const high = widen(first);
+            __m128i const low = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi16(widen(digits[0]), 6),
+                    _mm_slli_epi16(widen(digits[1]), 3)),
+                widen(digits[2]));
+            __m128i const quarters[2] = {
+                _mm_or_si128(_mm_unpacklo_epi16(low, zero),
+                    _mm_slli_epi32(_mm_unpacklo_epi16(high, zero), 9)),
+                _mm_or_si128(_mm_unpackhi_epi16(low, zero),
+                    _mm_slli_epi32(_mm_unpackhi_epi16(high, zero), 9))};
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(codes + 8 * half), quarters[0]);
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(codes + 8 * half + 4), quarters[1]);
+        }
+
+        for (; left_out != 0; left_out &= left_out - 1)
+        {
+            int const i = std::countr_zero(left_out);
+            codes[i] = soundex_packed(names[i]);
+        }
+    }
+#endif
+
+    template <typename Name>
+    void batch(std::span<Name const> names, std::span<packed_soundex> codes)
+    {
+        if (names.size() != codes.size())
+        {
+            throw std::runtime_error("soundex_batch: size mismatch");
+        }
+
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            for (; i + lanes <= names.size(); i += lanes)
+            {
+                std::string_view block[lanes];
+                std::copy(names.begin() + i, names.begin() + i + lanes, block);
+                encode_block(block, codes.data() + i);
+            }
+        }
+#endif
+        for (; i != names.size(); ++i)
+        {
+            codes[i] = soundex_packed(names[i]);
+        }
+    }
+}    // namespace
+
+void soundex_batch(
+    std::span<std::string const> names, std::span<packed_soundex> codes)
+{
+    batch(names, codes);
+}
+
+void soundex_batch(
+    std::span<std::string_view const> names, std::span<packed_soundex> codes)
+{
+    batch(names, codes);
+}
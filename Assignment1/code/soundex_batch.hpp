@@ -0,0 +1,25 @@
+// This file declares a soundex encoder for many names at once. The names
+// are taken 16 at a time and transposed into a block of byte columns, so
+// that the n-th characters of all 16 names sit in one SSE register. Each
+// column is then run through the steps of soundex_packed as masks across
+// the lanes: the letters are told apart by a compare, mapped to digits by a
+// table shuffle, and the adjacent duplicates, the zeros and the digits
+// after the third are dropped by blending, with no branch depending on the
+// letters.
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "soundex_code.hpp"
+
+// Stores the code of names[i] in codes[i], the same as soundex_packed
+// would. The names are encoded one by one without SSSE3, and so are the
+// names longer than 32 characters, empty or starting with '0'. Throws a
+// std::runtime_error if the spans differ in size.
+void soundex_batch(
+    std::span<std::string const> names, std::span<packed_soundex> codes);
+void soundex_batch(
+    std::span<std::string_view const> names, std::span<packed_soundex> codes);
@@ -0,0 +1,127 @@
+// This file implements the interface declared in soundex_code.hpp.
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "soundex_code.hpp"
+
+namespace {
+
+    // The table entry of the bytes that aren't letters.
+    constexpr std::uint8_t not_a_letter = 0xff;
+
+    // The soundex digit of every byte, in upper and lower case.
+    constexpr std::array<std::uint8_t, 256> letter_digits = [] {
+        std::array<std::uint8_t, 256> digits = {};
+        digits.fill(not_a_letter);
+        std::string_view const groups[] = {
+            "AEIOUHWY", "BFPV", "CGJKQSXZ", "DT", "L", "MN", "R"};
+        for (std::uint8_t digit = 0; digit != 7; ++digit)
+        {
+            for (char c : groups[digit])
+            {
+                digits[static_cast<unsigned char>(c)] = digit;
+                digits[static_cast<unsigned char>(c - 'A' + 'a')] = digit;
+            }
+        }
+        return digits;
+    }();
+
+    // std::toupper in the "C" locale, without the call.
+    constexpr char to_upper(char c)
+    {
+        return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    // Returns the code of a name starting with '0', which is discarded like
+    // the zero digits, so that the first digit takes its place. The digits
+    // come from the letters in [it, end), `previous` is the digit of the
+    // letter before them.
+    packed_soundex without_first_character(std::string_view::iterator it,
+        std::string_view::iterator end, std::uint8_t previous)
+    {
+        packed_soundex code = 0;
+        unsigned length = 0;
+        for (; it != end && length != 4; ++it)
+        {
+            std::uint8_t digit =
+                letter_digits[static_cast<unsigned char>(*it)];
+            if (digit == not_a_letter || digit == previous)
+            {
+                continue;
+            }
+            previous = digit;
+            if (digit != 0)
+            {
+                code |= length == 0
+                    ? packed_soundex('0' + digit) << 9
+                    : packed_soundex(digit) << (3 * (3 - length));
+                ++length;
+            }
+        }
+        return length == 0 ? packed_soundex('0') << 9 : code;
+    }
+}    // namespace
+
+packed_soundex soundex_packed(std::string_view name)
+{
+    if (name.empty())
+    {
+        return empty_soundex;
+    }
+
+    // the digits are coalesced starting with the one of the first letter,
+    // which is then replaced by the first character of the name
+    auto it = name.begin();
+    while (it != name.end() &&
+        letter_digits[static_cast<unsigned char>(*it)] == not_a_letter)
+    {
+        ++it;
+    }
+    if (it == name.end())
+    {
+        return packed_soundex('0') << 9;    // "0000", all zeros discarded
+    }
+    std::uint8_t previous = letter_digits[static_cast<unsigned char>(*it)];
+
+    char const first = to_upper(name.front());
+    if (first == '0')
+    {
+        return without_first_character(++it, name.end(), previous);
+    }
+
+    // Adjacent duplicates, zeros and the digits after the third are dropped
+    // without branching on the letters, which would be mispredicted about
+    // every other time. Walking on to the end of the name is cheaper.
+    packed_soundex digits = 0;
+    unsigned bits = 0;
+    for (++it; it != name.end(); ++it)
+    {
+        std::uint8_t digit = letter_digits[static_cast<unsigned char>(*it)];
+        unsigned const letter = digit != not_a_letter;
+        unsigned const kept =
+            letter & (digit != previous) & (digit != 0) & (bits < 9);
+        digits = (digits << (3 * kept)) | (digit * kept);
+        bits += 3 * kept;
+        previous = letter ? digit : previous;
+    }
+    return (packed_soundex(static_cast<unsigned char>(first)) << 9) |
+        (digits << (9 - bits));
+}
+
+std::string soundex_string(packed_soundex code)
+{
+    if (code == empty_soundex)
+    {
+        return {};
+    }
+    std::string result(4, '0');
+    result[0] = static_cast<char>(code >> 9);
+    for (unsigned i = 1; i != 4; ++i)
+    {
+        result[i] = static_cast<char>('0' + ((code >> (3 * (3 - i))) & 7));
+    }
+    return result;
+}
@@ -0,0 +1,32 @@
+// This file declares a soundex encoder that computes the code of a name in a
+// single pass, without building intermediate strings. The letters are turned
+// into digits through a table of all 256 byte values, adjacent duplicates and
+// zeros are dropped on the fly, and nothing is kept once the code has its
+// three digits. The code comes out packed into an integer, which is cheaper
+// to compare, hash and store than a string.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// A soundex code packed into 17 bits: its first character in bits 9 to 16
+// and its three digits, 0 to 6, in bits 6 to 8, 3 to 5 and 0 to 2.
+using packed_soundex = std::uint32_t;
+
+// The packed code of the empty name, whose soundex code is empty as well.
+inline constexpr packed_soundex empty_soundex = packed_soundex(1) << 17;
+
+// The number of distinct packed codes, for tables indexed by them.
+inline constexpr std::size_t packed_soundex_count = empty_soundex + 1;
+
+// Returns the soundex code of `name` like soundex() in soundex.cpp: the
+// first character is the uppercase first character of the name even if that
+// isn't a letter (and is dropped if it is '0'), the digits come from the
+// letters only, and a name without letters gets "0000".
+packed_soundex soundex_packed(std::string_view name);
+
+// Returns the four characters of a packed code, or "" for empty_soundex.
+std::string soundex_string(packed_soundex code);
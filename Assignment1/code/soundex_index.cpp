@@ -0,0 +1,69 @@
+// This file implements the interface declared in soundex_index.hpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "soundex_batch.hpp"
+#include "soundex_code.hpp"
+#include "soundex_index.hpp"
+
+namespace {
+
+    // Returns the code of every name.
+    template <typename Name>
+    std::vector<packed_soundex> codes_of(std::span<Name const> names)
+    {
+        if (names.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::runtime_error("soundex_index: too many names");
+        }
+        std::vector<packed_soundex> codes(names.size());
+        soundex_batch(names, codes);
+        return codes;
+    }
+}    // namespace
+
+soundex_index::soundex_index(std::span<std::string const> names)
+{
+    build(codes_of(names));
+}
+
+soundex_index::soundex_index(std::span<std::string_view const> names)
+{
+    build(codes_of(names));
+}
+
+void soundex_index::build(std::vector<packed_soundex> const& codes)
+{
+    offsets.assign(packed_soundex_count + 1, 0);
+    ids.resize(codes.size());
+
+    // count the names per code, shifted by one so that the prefix sums
+    // become the start of each run
+    for (packed_soundex code : codes)
+    {
+        ++offsets[code + 1];
+    }
+    for (std::size_t c = 1; c != offsets.size(); ++c)
+    {
+        offsets[c] += offsets[c - 1];
+    }
+
+    // place the ids, advancing the start of each run as it fills up, then
+    // restore the starts
+    for (std::size_t i = 0; i != codes.size(); ++i)
+    {
+        ids[offsets[codes[i]]++] = static_cast<std::uint32_t>(i);
+    }
+    for (std::size_t c = offsets.size() - 1; c != 0; --c)
+    {
+        offsets[c] = offsets[c - 1];
+    }
+    offsets[0] = 0;
+}
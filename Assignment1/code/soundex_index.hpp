@@ -0,0 +1,52 @@
+// This file declares an index from soundex codes to the names having them.
+// It is built once in a counting sort over the codes of all names and laid
+// out in compressed sparse row form: the ids of the names sharing a code are
+// stored next to each other, in the order of the names, and an array indexed
+// by the packed code holds where each run starts. Looking up a code is then
+// two loads, however many names there are.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "soundex_code.hpp"
+
+class soundex_index
+{
+    // the ids of the names with code c are ids[offsets[c]] up to, but not
+    // including, ids[offsets[c + 1]]
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> ids;
+
+    // fill in the tables given the code of every name
+    void build(std::vector<packed_soundex> const& codes);
+
+public:
+    // Index the names, the id of a name being its position in `names`.
+    // Throws a std::runtime_error for 2^32 names or more.
+    explicit soundex_index(std::span<std::string const> names);
+    explicit soundex_index(std::span<std::string_view const> names);
+
+    // Return the ids of the names with the given code in increasing order,
+    // none for a value that isn't a packed code.
+    std::span<std::uint32_t const> find(packed_soundex code) const
+    {
+        if (code >= packed_soundex_count)
+        {
+            return {};
+        }
+        return std::span(ids).subspan(
+            offsets[code], offsets[code + 1] - offsets[code]);
+    }
+
+    // Return the number of names indexed.
+    std::size_t size() const
+    {
+        return ids.size();
+    }
+};
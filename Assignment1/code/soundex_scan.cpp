@@ -0,0 +1,95 @@
+// This file implements the interface declared in soundex_scan.hpp.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "soundex_batch.hpp"
+#include "soundex_code.hpp"
+#include "soundex_scan.hpp"
+#include "thread_count.hpp"
+
+namespace {
+
+    // Each thread gets at least this many names.
+    constexpr std::size_t min_names_per_thread = 1 << 15;
+
+    // The names encoded at once by soundex_batch, their codes fit in L1.
+    constexpr std::size_t names_per_batch = 256;
+
+    template <typename Name>
+    std::vector<std::uint32_t> scan(
+        std::span<Name const> names, packed_soundex code, unsigned num_threads)
+    {
+        if (names.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::runtime_error("soundex_scan: too many names");
+        }
+        if (num_threads == 0)
+        {
+            num_threads = default_thread_count();
+        }
+        num_threads = static_cast<unsigned>(std::clamp<std::size_t>(
+            names.size() / min_names_per_thread, 1, num_threads));
+
+        std::vector<std::vector<std::uint32_t>> matches(num_threads);
+        auto worker = [&](unsigned thread) {
+            std::size_t const begin = names.size() * thread / num_threads;
+            std::size_t const end = names.size() * (thread + 1) / num_threads;
+            std::vector<std::uint32_t>& found = matches[thread];
+            std::array<packed_soundex, names_per_batch> codes;
+            for (std::size_t i = begin; i < end; i += names_per_batch)
+            {
+                std::size_t const n = std::min(end - i, names_per_batch);
+                soundex_batch(names.subspan(i, n), std::span(codes).first(n));
+                for (std::size_t k = 0; k != n; ++k)
+                {
+                    if (codes[k] == code)
+                    {
+                        found.push_back(static_cast<std::uint32_t>(i + k));
+                    }
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            for (unsigned i = 1; i < num_threads; ++i)
+            {
+                threads.emplace_back(worker, i);
+            }
+            worker(0);
+        }    // joins all threads
+
+        std::vector<std::uint32_t> result = std::move(matches[0]);
+        for (unsigned thread = 1; thread < num_threads; ++thread)
+        {
+            result.insert(result.end(), matches[thread].begin(),
+                matches[thread].end());
+        }
+        return result;
+    }
+}    // namespace
+
+std::vector<std::uint32_t> soundex_scan(
+    std::span<std::string const> names, packed_soundex code,
+    unsigned num_threads)
+{
+    return scan(names, code, num_threads);
+}
+
+std::vector<std::uint32_t> soundex_scan(
+    std::span<std::string_view const> names, packed_soundex code,
+    unsigned num_threads)
+{
+    return scan(names, code, num_threads);
+}
@@ -0,0 +1,27 @@
+// This file declares the search for the names with a given soundex code
+// without an index, encoding every name. The names are cut into one
+// contiguous part per thread, each thread collects the matches of its part
+// in a buffer of its own, and the buffers are joined in the order of the
+// parts, so the matches come out in the order of the names without the
+// threads ever synchronizing.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "soundex_code.hpp"
+
+// Returns the positions of the names with the given code in increasing
+// order, using up to `num_threads` threads (0 for default_thread_count).
+// Short lists are scanned on fewer threads, starting a thread costs as much
+// as encoding thousands of names.
+// Throws a std::runtime_error for 2^32 names or more.
+std::vector<std::uint32_t> soundex_scan(std::span<std::string const> names,
+    packed_soundex code, unsigned num_threads = 0);
+std::vector<std::uint32_t> soundex_scan(
+    std::span<std::string_view const> names, packed_soundex code,
+    unsigned num_threads = 0);
@@ -0,0 +1,85 @@
+// This file implements the interface declared in surname_file.hpp.
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "mapped_file.hpp"
+#include "surname_file.hpp"
+
+namespace {
+
+    // The mean length of a line assumed to reserve the records up front,
+    // the surnames average 7 letters.
+    constexpr std::size_t expected_line_length = 8;
+
+    // Calls f(i) for every i with text[i] == '\n' in increasing order. With
+    // SSE2 the text is compared 16 bytes at a time, and the results of 64
+    // bytes are collected into a bit mask, the set bits of which are the
+    // newlines.
+    template <typename F>
+    void for_each_newline(std::string_view text, F f)
+    {
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        __m128i const newline = _mm_set1_epi8('\n');
+        for (; i + 64 <= text.size(); i += 64)
+        {
+            std::uint64_t mask = 0;
+            for (std::size_t k = 0; k != 4; ++k)
+            {
+                __m128i bytes = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(text.data() + i + 16 * k));
+                auto matches = static_cast<std::uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+                mask |= std::uint64_t(matches) << (16 * k);
+            }
+            while (mask != 0)
+            {
+                f(i + std::countr_zero(mask));
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i != text.size(); ++i)
+        {
+            if (text[i] == '\n')
+            {
+                f(i);
+            }
+        }
+    }
+}    // namespace
+
+surname_file::surname_file(std::string const& path)
+  : file(path, mapped_file::access::read_only)
+{
+    std::span<std::byte const> bytes = file.bytes();
+    std::string_view const text(
+        reinterpret_cast<char const*>(bytes.data()), bytes.size());
+    records.reserve(text.size() / expected_line_length);
+
+    std::size_t start = 0;
+    auto add_line = [&](std::size_t end) {
+        if (end != start && text[end - 1] == '\r')
+        {
+            --end;
+        }
+        if (end != start)
+        {
+            records.push_back(text.substr(start, end - start));
+        }
+    };
+    for_each_newline(text, [&](std::size_t i) {
+        add_line(i);
+        start = i + 1;
+    });
+    add_line(text.size());    // a last line without a newline
+}
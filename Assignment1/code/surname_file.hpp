@@ -0,0 +1,44 @@
+// This file declares a list of names loaded from a file with one name per
+// line. The file is mapped into memory rather than read, and the names are
+// views of the mapping rather than strings of their own, so loading the
+// list costs one pass over the file to find the line breaks and a single
+// allocation.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+class surname_file
+{
+    mapped_file file;
+    std::vector<std::string_view> records;    // point into `file`
+
+public:
+    // Map the file at `path` and split it into lines. Empty lines are
+    // skipped, a '\r' ending a line is dropped. Throws a std::system_error
+    // if the file can't be opened or mapped.
+    explicit surname_file(std::string const& path);
+
+    // Return the names in the order of the file. They stay valid for as
+    // long as this object, moving it doesn't invalidate them.
+    std::span<std::string_view const> names() const
+    {
+        return records;
+    }
+
+    std::size_t size() const
+    {
+        return records.size();
+    }
+
+    std::string_view operator[](std::size_t i) const
+    {
+        return records[i];
+    }
+};
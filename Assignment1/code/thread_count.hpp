@@ -0,0 +1,17 @@
+// This file declares the number of threads the parallel routines use by
+// default. Throughout this directory, passing 0 threads to a routine that
+// takes `num_threads` selects default_thread_count().
+
+#pragma once
+
+#include <algorithm>
+#include <thread>
+
+// Returns std::thread::hardware_concurrency, or 1 if that is unknown.
+inline unsigned default_thread_count()
+{
+    // querying this is not free, cache it
+    static unsigned const hardware_threads =
+        std::max(std::thread::hardware_concurrency(), 1u);
+    return hardware_threads;
+}